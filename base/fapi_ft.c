@@ -41,6 +41,10 @@
 #include "gsfname.h"
 
 #include "gxfapi.h"
+#include "gsmd5.h"
+#include "gslibctx.h"
+#include "gp.h"
+#include "gssprintf.h"
 
 
 /* FreeType headers */
@@ -59,6 +63,7 @@
 #include FT_TRUETYPE_TABLES_H
 #include FT_MULTIPLE_MASTERS_H
 #include FT_TYPE1_TABLES_H
+#include FT_SIZES_H
 
 /* Note: structure definitions here start with FF_, which stands for 'FAPI FreeType". */
 
@@ -74,10 +79,28 @@ typedef struct ff_server_s
     gs_memory_t *mem;
     FT_Memory ftmemory;
     struct FT_MemoryRec_ ftmemory_rec;
+    struct ff_gcache_strike_s *gcache;  /* persistent glyph cache strikes */
 } ff_server;
 
 
 
+/* Setting the character size resets a TrueType size object, so that the
+ * font's 'prep' program is run again before the next hinted glyph.  Since the
+ * scaled font is set up again for each glyph, each face keeps a few sizes,
+ * one per scale recently used, and just activates the matching one.
+ */
+#define FF_NUM_SIZES 8
+
+typedef struct ff_size_s
+{
+    FT_Size ft_size;
+    FT_F26Dot6 width, height;
+    FT_UInt horz_res;
+    FT_UInt vert_res;
+    bool valid;
+    uint last_used;
+} ff_size;
+
 typedef struct ff_face_s
 {
     FT_Face ft_face;
@@ -88,6 +111,11 @@ typedef struct ff_face_s
     FT_UInt horz_res;
     FT_UInt vert_res;
 
+    /* sizes[0] is the face's own size; the others are made as needed. */
+    ff_size sizes[FF_NUM_SIZES];
+    int num_sizes;
+    uint size_clock;
+
     /* If non-null, the incremental interface object passed to FreeType. */
     FT_Incremental_InterfaceRec *ft_inc_int;
     /* If non-null, we're using a custom stream object for Freetype to read the font file */
@@ -97,6 +125,12 @@ typedef struct ff_face_s
     int font_data_len;
     bool data_owned;
     ff_server *server;
+    /* Persistent glyph cache: digest of the font data, valid if
+       gcache_state > 0 (< 0 if the face can't be cached), and the strike
+       used last. */
+    int gcache_state;
+    unsigned char gcache_digest[16];
+    struct ff_gcache_strike_s *gcache_strike;
 } ff_face;
 
 /* Here we define the struct FT_Incremental that is used as an opaque type
@@ -290,10 +324,67 @@ new_face(gs_fapi_server * a_server, FT_Face a_ft_face,
         face->data_owned = data_owned;
         face->ftstrm = ftstrm;
         face->server = (ff_server *) a_server;
+        face->gcache_state = 0;
+        face->gcache_strike = NULL;
+        memset(face->sizes, 0x00, sizeof(face->sizes));
+        face->num_sizes = 0;
+        face->size_clock = 0;
     }
     return face;
 }
 
+/* Make the face's current width, height and resolution the active size,
+ * reusing a size object of the same scale if there is one.
+ */
+static FT_Error
+set_face_size(ff_face *face)
+{
+    ff_size *sz, *lru = NULL;
+    FT_Error ft_error;
+    int i;
+
+    face->size_clock++;
+    for (i = 0; i < face->num_sizes; i++) {
+        sz = &face->sizes[i];
+        if (sz->valid && sz->width == face->width && sz->height == face->height
+            && sz->horz_res == face->horz_res && sz->vert_res == face->vert_res) {
+            sz->last_used = face->size_clock;
+            return FT_Activate_Size(sz->ft_size);
+        }
+        if (lru == NULL || sz->last_used < lru->last_used)
+            lru = sz;
+    }
+    if (face->num_sizes == 0) {
+        sz = &face->sizes[0];
+        sz->ft_size = face->ft_face->size;
+        face->num_sizes = 1;
+    }
+    else if (face->num_sizes < FF_NUM_SIZES) {
+        sz = &face->sizes[face->num_sizes];
+        ft_error = FT_New_Size(face->ft_face, &sz->ft_size);
+        if (ft_error)
+            return ft_error;
+        face->num_sizes++;
+    }
+    else
+        sz = lru;
+
+    sz->valid = false;
+    ft_error = FT_Activate_Size(sz->ft_size);
+    if (!ft_error)
+        ft_error = FT_Set_Char_Size(face->ft_face, face->width, face->height,
+                                    face->horz_res, face->vert_res);
+    if (!ft_error) {
+        sz->width = face->width;
+        sz->height = face->height;
+        sz->horz_res = face->horz_res;
+        sz->vert_res = face->vert_res;
+        sz->valid = true;
+        sz->last_used = face->size_clock;
+    }
+    return ft_error;
+}
+
 static void
 delete_face(gs_fapi_server * a_server, ff_face * a_face)
 {
@@ -916,6 +1007,556 @@ load_glyph(gs_fapi_server * a_server, gs_fapi_font * a_fapi_font,
     return ft_to_gs_error(ft_error);
 }
 
+/* ------ Persistent glyph cache ------ */
+
+/*
+ * If GlyphCacheDir is set, the bitmaps rendered for faces which FreeType
+ * reads in full (from a file or from a memory buffer, rather than through
+ * the incremental interface) are kept in that directory, one file per
+ * "strike": a font, identified by an MD5 digest of its data, rendered
+ * with one transform, resolution and set of hinting options. A later run
+ * rendering the same font at the same size takes the bitmaps and metrics
+ * from the file instead of running FreeType again.
+ *
+ * A strike file is read in full the first time its strike is used, and
+ * rewritten when the server is destroyed if glyphs were added. It is
+ * written to a scratch file in the same directory which is then renamed,
+ * so other processes never see a partial file; if two processes add to
+ * the same strike the last one to finish wins.
+ */
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 10)
+#  define FF_GCACHE 1           /* We need FT_New_Glyph. */
+#else
+#  define FF_GCACHE 0
+#endif
+
+#if FF_GCACHE
+
+#define FF_GCACHE_MAGIC "GSGC"
+#define FF_GCACHE_VERSION 1
+/* Strike key: font digest, FreeType version, subfont, transform,
+   character size, resolution, hinting options and cmap. */
+#define FF_GCACHE_KEY_SIZE (16 + 4 * 4 + 8 * 6 + 4 * 2 + 4 * 5 + 4 * 2)
+/* Glyph record header: glyph key, metrics and bitmap geometry. */
+#define FF_GCACHE_GLYPH_SIZE (8 + 4 + 8 + 4 * 2 + 4 * 8 + 4 * 5)
+#define FF_GCACHE_HEADER_SIZE (4 + 4 + FF_GCACHE_KEY_SIZE + 4)
+/* Bitmap bytes kept per strike; later glyphs aren't cached. */
+#define FF_GCACHE_MAX_BYTES (4 * 1024 * 1024)
+#define FF_GCACHE_READ_SIZE 16384
+
+typedef struct ff_gcache_glyph_s
+{
+    gs_glyph code;
+    int is_glyph_index;
+    gs_char client_char_code;
+    int sb_x, sb_y;
+    gs_fapi_metrics metrics;
+    int width, rows, pitch, left, top;
+    unsigned char *data;        /* rows * pitch bytes */
+    bool data_owned;            /* else data points into the strike file */
+} ff_gcache_glyph;
+
+typedef struct ff_gcache_strike_s ff_gcache_strike;
+struct ff_gcache_strike_s
+{
+    ff_gcache_strike *next;
+    unsigned char key[FF_GCACHE_KEY_SIZE];
+    unsigned char *file_data;   /* the strike file as read, or NULL */
+    ff_gcache_glyph *glyphs;
+    int count, max_count;
+    int *index;                 /* glyph number + 1, or 0 if free */
+    int index_size;             /* a power of 2 above 2 * max_count */
+    long bytes;                 /* bitmap bytes held */
+    bool dirty;
+};
+
+static unsigned char *
+gcache_put32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+    return p + 4;
+}
+
+static unsigned char *
+gcache_put64(unsigned char *p, uint64_t v)
+{
+    return gcache_put32(gcache_put32(p, (uint32_t)(v >> 32)), (uint32_t)v);
+}
+
+static uint32_t
+gcache_get32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t
+gcache_get64(const unsigned char *p)
+{
+    return ((uint64_t)gcache_get32(p) << 32) | gcache_get32(p + 4);
+}
+
+/* Compute the digest of the face's font data. */
+static int
+gcache_digest_face(ff_server *s, ff_face *face)
+{
+    gs_md5_state_t md5;
+
+    gs_md5_init(&md5);
+    if (face->font_data != NULL && face->font_data_len > 0)
+        gs_md5_append(&md5, face->font_data, face->font_data_len);
+    else if (face->ftstrm != NULL && face->ftstrm->read != NULL) {
+        unsigned long pos = 0, size = face->ftstrm->size, n;
+        unsigned char *buf = gs_malloc(s->mem, FF_GCACHE_READ_SIZE, 1,
+                                       "gcache_digest_face");
+
+        if (buf == NULL)
+            return -1;
+        while (pos < size) {
+            n = min(size - pos, FF_GCACHE_READ_SIZE);
+            if (face->ftstrm->read(face->ftstrm, pos, buf, n) != n)
+                break;
+            gs_md5_append(&md5, buf, (int)n);
+            pos += n;
+        }
+        gs_free(s->mem, buf, 0, 0, "gcache_digest_face");
+        if (pos < size)
+            return -1;
+    }
+    else
+        return -1;
+    gs_md5_finish(&md5, face->gcache_digest);
+    return 1;
+}
+
+static void
+gcache_make_key(gs_fapi_server *a_server, gs_fapi_font *a_font,
+                ff_face *face, unsigned char *key)
+{
+    FT_CharMap cmap = face->ft_face->charmap;
+    unsigned char *p = key;
+
+    memcpy(p, face->gcache_digest, 16);
+    p += 16;
+    p = gcache_put32(p, FF_GCACHE_VERSION);
+    p = gcache_put32(p, FREETYPE_MAJOR);
+    p = gcache_put32(p, FREETYPE_MINOR);
+    p = gcache_put32(p, FREETYPE_PATCH);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->ft_transform.xx);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->ft_transform.xy);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->ft_transform.yx);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->ft_transform.yy);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->width);
+    p = gcache_put64(p, (uint64_t)(int64_t)face->height);
+    p = gcache_put32(p, face->horz_res);
+    p = gcache_put32(p, face->vert_res);
+    p = gcache_put32(p, a_font->subfont);
+    p = gcache_put32(p, a_server->grid_fit);
+    p = gcache_put32(p, a_font->is_type1);
+    p = gcache_put32(p, a_font->is_mtx_skipped);
+    p = gcache_put32(p, a_font->is_vertical | (a_font->is_cid << 1));
+    p = gcache_put32(p, cmap ? cmap->platform_id : 0xffff);
+    (void)gcache_put32(p, cmap ? cmap->encoding_id : 0xffff);
+}
+
+static ff_gcache_glyph *
+gcache_find(ff_gcache_strike *strike, const gs_fapi_char_ref *cr)
+{
+    uint32_t h;
+    int i, mask = strike->index_size - 1;
+
+    if (strike->index_size == 0)
+        return NULL;
+    h = (uint32_t)cr->char_codes[0] * 0x9E3779B1u ^ (uint32_t)cr->client_char_code;
+    for (i = (int)(h & mask); strike->index[i] != 0; i = (i + 1) & mask) {
+        ff_gcache_glyph *g = &strike->glyphs[strike->index[i] - 1];
+
+        if (g->code == cr->char_codes[0] &&
+            g->is_glyph_index == cr->is_glyph_index &&
+            g->client_char_code == cr->client_char_code &&
+            g->sb_x == cr->sb_x && g->sb_y == cr->sb_y)
+            return g;
+    }
+    return NULL;
+}
+
+static void
+gcache_insert(ff_gcache_strike *strike, int n)
+{
+    const ff_gcache_glyph *g = &strike->glyphs[n];
+    uint32_t h = (uint32_t)g->code * 0x9E3779B1u ^ (uint32_t)g->client_char_code;
+    int i, mask = strike->index_size - 1;
+
+    for (i = (int)(h & mask); strike->index[i] != 0; i = (i + 1) & mask)
+        DO_NOTHING;
+    strike->index[i] = n + 1;
+}
+
+/* Make room for at least one more glyph. */
+static int
+gcache_grow(ff_server *s, ff_gcache_strike *strike)
+{
+    int max_count = max(strike->max_count * 2, 64);
+    int index_size = strike->index_size ? strike->index_size : 128;
+    ff_gcache_glyph *glyphs;
+    int *index, i;
+
+    if (strike->count < strike->max_count)
+        return 0;
+    while (index_size <= max_count * 2)
+        index_size <<= 1;
+    glyphs = gs_malloc(s->mem, max_count, sizeof(ff_gcache_glyph),
+                       "gcache_grow(glyphs)");
+    index = gs_malloc(s->mem, index_size, sizeof(int), "gcache_grow(index)");
+    if (glyphs == NULL || index == NULL) {
+        gs_free(s->mem, glyphs, 0, 0, "gcache_grow(glyphs)");
+        gs_free(s->mem, index, 0, 0, "gcache_grow(index)");
+        return_error(gs_error_VMerror);
+    }
+    if (strike->count > 0)
+        memcpy(glyphs, strike->glyphs, strike->count * sizeof(ff_gcache_glyph));
+    memset(index, 0, index_size * sizeof(int));
+    gs_free(s->mem, strike->glyphs, 0, 0, "gcache_grow(glyphs)");
+    gs_free(s->mem, strike->index, 0, 0, "gcache_grow(index)");
+    strike->glyphs = glyphs;
+    strike->max_count = max_count;
+    strike->index = index;
+    strike->index_size = index_size;
+    for (i = 0; i < strike->count; i++)
+        gcache_insert(strike, i);
+    return 0;
+}
+
+static void
+gcache_file_name(const char *dir, const ff_gcache_strike *strike, char *fname)
+{
+    gs_md5_state_t md5;
+    unsigned char digest[16];
+    char hex[33];
+    const char *sep = gp_file_name_directory_separator();
+    int dirlen = strlen(dir), i;
+
+    gs_md5_init(&md5);
+    gs_md5_append(&md5, strike->key, FF_GCACHE_KEY_SIZE);
+    gs_md5_finish(&md5, digest);
+    for (i = 0; i < 16; i++)
+        gs_snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    if (dirlen > 0 && dir[dirlen - 1] == sep[0])
+        sep = "";
+    gs_snprintf(fname, gp_file_name_sizeof, "%s%sgsgc_%s", dir, sep, hex);
+}
+
+/* Read a strike file, leaving the strike empty if it is missing or bad. */
+static void
+gcache_read_strike(ff_server *s, ff_gcache_strike *strike, const char *dir)
+{
+    char fname[gp_file_name_sizeof];
+    gs_md5_state_t md5;
+    unsigned char digest[16];
+    unsigned char *buf = NULL, *p, *end;
+    gp_file *f;
+    gs_offset_t len = 0;
+    int count, i;
+
+    gcache_file_name(dir, strike, fname);
+    f = gp_fopen(s->mem, fname, "rb");
+    if (f == NULL)
+        return;
+    if (gp_fseek(f, 0, SEEK_END) == 0 && (len = gp_ftell(f)) > 0 &&
+        len >= FF_GCACHE_HEADER_SIZE + 16 &&
+        len <= 2 * FF_GCACHE_MAX_BYTES && gp_fseek(f, 0, SEEK_SET) == 0) {
+        buf = gs_malloc(s->mem, len, 1, "gcache_read_strike");
+        if (buf != NULL && gp_fread(buf, 1, len, f) != (size_t)len) {
+            gs_free(s->mem, buf, 0, 0, "gcache_read_strike");
+            buf = NULL;
+        }
+    }
+    gp_fclose(f);
+    if (buf == NULL)
+        return;
+
+    end = buf + len - 16;
+    gs_md5_init(&md5);
+    gs_md5_append(&md5, buf, (int)(end - buf));
+    gs_md5_finish(&md5, digest);
+    if (memcmp(digest, end, 16) != 0 || memcmp(buf, FF_GCACHE_MAGIC, 4) != 0 ||
+        gcache_get32(buf + 4) != FF_GCACHE_VERSION ||
+        memcmp(buf + 8, strike->key, FF_GCACHE_KEY_SIZE) != 0)
+        goto bad;
+    p = buf + 8 + FF_GCACHE_KEY_SIZE;
+    count = (int)gcache_get32(p);
+    p += 4;
+    for (i = 0; i < count; i++) {
+        ff_gcache_glyph *g;
+        long size;
+
+        if (end - p < FF_GCACHE_GLYPH_SIZE || gcache_grow(s, strike) < 0)
+            goto bad;
+        g = &strike->glyphs[strike->count];
+        g->code = gcache_get64(p);
+        g->is_glyph_index = (int)gcache_get32(p + 8);
+        g->client_char_code = gcache_get64(p + 12);
+        g->sb_x = (int)gcache_get32(p + 20);
+        g->sb_y = (int)gcache_get32(p + 24);
+        g->metrics.bbox_x0 = (int)gcache_get32(p + 28);
+        g->metrics.bbox_y0 = (int)gcache_get32(p + 32);
+        g->metrics.bbox_x1 = (int)gcache_get32(p + 36);
+        g->metrics.bbox_y1 = (int)gcache_get32(p + 40);
+        g->metrics.escapement = (int)gcache_get32(p + 44);
+        g->metrics.v_escapement = (int)gcache_get32(p + 48);
+        g->metrics.em_x = (int)gcache_get32(p + 52);
+        g->metrics.em_y = (int)gcache_get32(p + 56);
+        g->width = (int)gcache_get32(p + 60);
+        g->rows = (int)gcache_get32(p + 64);
+        g->pitch = (int)gcache_get32(p + 68);
+        g->left = (int)gcache_get32(p + 72);
+        g->top = (int)gcache_get32(p + 76);
+        p += FF_GCACHE_GLYPH_SIZE;
+        if (g->width < 0 || g->rows < 0 || g->pitch < 0 ||
+            g->width > g->pitch * 8 || (g->rows > 0 && g->pitch > (end - p) / g->rows))
+            goto bad;
+        size = (long)g->rows * g->pitch;
+        g->data = p;
+        g->data_owned = false;
+        p += size;
+        strike->bytes += size;
+        gcache_insert(strike, strike->count++);
+    }
+    if (p != end)
+        goto bad;
+    strike->file_data = buf;
+    return;
+
+  bad:
+    strike->count = 0;
+    strike->bytes = 0;
+    if (strike->index != NULL)
+        memset(strike->index, 0, strike->index_size * sizeof(int));
+    gs_free(s->mem, buf, 0, 0, "gcache_read_strike");
+}
+
+/* Write a strike file, ignoring errors: the cache is only an optimisation. */
+static void
+gcache_write_strike(ff_server *s, ff_gcache_strike *strike, const char *dir)
+{
+    char fname[gp_file_name_sizeof], prefix[gp_file_name_sizeof];
+    char tmpname[gp_file_name_sizeof];
+    unsigned char head[FF_GCACHE_HEADER_SIZE > FF_GCACHE_GLYPH_SIZE ?
+                       FF_GCACHE_HEADER_SIZE : FF_GCACHE_GLYPH_SIZE];
+    unsigned char digest[16], *p;
+    gs_md5_state_t md5;
+    bool ok = true;
+    gp_file *f;
+    int i;
+
+    gcache_file_name(dir, strike, fname);
+    gs_snprintf(prefix, sizeof(prefix), "%s.", fname);
+    f = gp_open_scratch_file(s->mem, prefix, tmpname, "wb");
+    if (f == NULL)
+        return;
+    gs_md5_init(&md5);
+    memcpy(head, FF_GCACHE_MAGIC, 4);
+    p = gcache_put32(head + 4, FF_GCACHE_VERSION);
+    memcpy(p, strike->key, FF_GCACHE_KEY_SIZE);
+    (void)gcache_put32(p + FF_GCACHE_KEY_SIZE, strike->count);
+    gs_md5_append(&md5, head, FF_GCACHE_HEADER_SIZE);
+    ok = gp_fwrite(head, 1, FF_GCACHE_HEADER_SIZE, f) == FF_GCACHE_HEADER_SIZE;
+    for (i = 0; ok && i < strike->count; i++) {
+        const ff_gcache_glyph *g = &strike->glyphs[i];
+        int size = g->rows * g->pitch;
+
+        p = gcache_put64(head, g->code);
+        p = gcache_put32(p, g->is_glyph_index);
+        p = gcache_put64(p, g->client_char_code);
+        p = gcache_put32(p, g->sb_x);
+        p = gcache_put32(p, g->sb_y);
+        p = gcache_put32(p, g->metrics.bbox_x0);
+        p = gcache_put32(p, g->metrics.bbox_y0);
+        p = gcache_put32(p, g->metrics.bbox_x1);
+        p = gcache_put32(p, g->metrics.bbox_y1);
+        p = gcache_put32(p, g->metrics.escapement);
+        p = gcache_put32(p, g->metrics.v_escapement);
+        p = gcache_put32(p, g->metrics.em_x);
+        p = gcache_put32(p, g->metrics.em_y);
+        p = gcache_put32(p, g->width);
+        p = gcache_put32(p, g->rows);
+        p = gcache_put32(p, g->pitch);
+        p = gcache_put32(p, g->left);
+        (void)gcache_put32(p, g->top);
+        gs_md5_append(&md5, head, FF_GCACHE_GLYPH_SIZE);
+        gs_md5_append(&md5, g->data, size);
+        ok = gp_fwrite(head, 1, FF_GCACHE_GLYPH_SIZE, f) == FF_GCACHE_GLYPH_SIZE &&
+             gp_fwrite(g->data, 1, size, f) == (size_t)size;
+    }
+    gs_md5_finish(&md5, digest);
+    if (ok)
+        ok = gp_fwrite(digest, 1, 16, f) == 16;
+    if (gp_fclose(f) != 0)
+        ok = false;
+    if (!ok || gp_rename(s->mem, tmpname, fname) != 0)
+        (void)gp_unlink(s->mem, tmpname);
+}
+
+/* Return the strike for the face's current scaling, or NULL if the glyph
+   cache is off or can't be used for this face. */
+static ff_gcache_strike *
+gcache_strike(gs_fapi_server *a_server, gs_fapi_font *a_font)
+{
+    ff_server *s = (ff_server *) a_server;
+    ff_face *face = (ff_face *) a_font->server_font_data;
+    const char *dir = gs_lib_ctx_get_glyph_cache_dir(s->mem);
+    unsigned char key[FF_GCACHE_KEY_SIZE];
+    ff_gcache_strike *strike;
+
+    if (dir == NULL || face == NULL || face->ft_inc_int != NULL ||
+        a_font->metrics_only)
+        return NULL;
+    if (face->gcache_state == 0)
+        face->gcache_state = gcache_digest_face(s, face);
+    if (face->gcache_state < 0)
+        return NULL;
+    gcache_make_key(a_server, a_font, face, key);
+    strike = face->gcache_strike;
+    if (strike != NULL && !memcmp(strike->key, key, FF_GCACHE_KEY_SIZE))
+        return strike;
+    for (strike = s->gcache; strike != NULL; strike = strike->next)
+        if (!memcmp(strike->key, key, FF_GCACHE_KEY_SIZE))
+            break;
+    if (strike == NULL) {
+        strike = gs_malloc(s->mem, 1, sizeof(ff_gcache_strike), "gcache_strike");
+        if (strike == NULL)
+            return NULL;
+        memset(strike, 0, sizeof(*strike));
+        memcpy(strike->key, key, FF_GCACHE_KEY_SIZE);
+        gcache_read_strike(s, strike, dir);
+        strike->next = s->gcache;
+        s->gcache = strike;
+    }
+    face->gcache_strike = strike;
+    return strike;
+}
+
+/* Make a cached glyph the current bitmap, as load_glyph would have. */
+static bool
+gcache_lookup(gs_fapi_server *a_server, ff_gcache_strike *strike,
+              const gs_fapi_char_ref *a_char_ref, gs_fapi_metrics *a_metrics)
+{
+    ff_server *s = (ff_server *) a_server;
+    ff_gcache_glyph *g = gcache_find(strike, a_char_ref);
+    FT_Glyph glyph;
+    FT_BitmapGlyph bmg;
+    long size;
+
+    /* Glyphs too big for the character cache fail in load_glyph. */
+    if (g == NULL || bitmap_raster(g->width) * g->rows >= a_server->max_bitmap)
+        return false;
+    if (FT_New_Glyph(s->freetype_library, FT_GLYPH_FORMAT_BITMAP, &glyph))
+        return false;
+    bmg = (FT_BitmapGlyph) glyph;
+    size = (long)g->rows * g->pitch;
+    if (size > 0) {
+        bmg->bitmap.buffer = FF_alloc(s->ftmemory, size);
+        if (bmg->bitmap.buffer == NULL) {
+            FT_Done_Glyph(glyph);
+            return false;
+        }
+        memcpy(bmg->bitmap.buffer, g->data, size);
+    }
+    bmg->bitmap.width = g->width;
+    bmg->bitmap.rows = g->rows;
+    bmg->bitmap.pitch = g->pitch;
+    bmg->bitmap.pixel_mode = FT_PIXEL_MODE_MONO;
+    bmg->bitmap.num_grays = 2;
+    bmg->left = g->left;
+    bmg->top = g->top;
+
+    if (s->bitmap_glyph) {
+        FT_Bitmap_Done(s->freetype_library, &s->bitmap_glyph->bitmap);
+        FF_free(s->ftmemory, s->bitmap_glyph);
+    }
+    if (s->outline_glyph) {
+        FT_Outline_Done(s->freetype_library, &s->outline_glyph->outline);
+        FF_free(s->ftmemory, s->outline_glyph);
+        s->outline_glyph = NULL;
+    }
+    s->bitmap_glyph = bmg;
+    if (a_metrics)
+        *a_metrics = g->metrics;
+    return true;
+}
+
+/* Add the bitmap load_glyph just rendered to the strike. */
+static void
+gcache_add(gs_fapi_server *a_server, ff_gcache_strike *strike,
+           const gs_fapi_char_ref *a_char_ref, const gs_fapi_metrics *a_metrics)
+{
+    ff_server *s = (ff_server *) a_server;
+    FT_BitmapGlyph bmg = s->bitmap_glyph;
+    ff_gcache_glyph *g;
+    long size;
+
+    if (bmg == NULL || a_metrics == NULL ||
+        bmg->root.format != FT_GLYPH_FORMAT_BITMAP ||
+        bmg->bitmap.pixel_mode != FT_PIXEL_MODE_MONO || bmg->bitmap.pitch < 0)
+        return;
+    size = (long)bmg->bitmap.rows * bmg->bitmap.pitch;
+    if (strike->bytes + size > FF_GCACHE_MAX_BYTES ||
+        gcache_find(strike, a_char_ref) != NULL ||
+        gcache_grow(s, strike) < 0)
+        return;
+    g = &strike->glyphs[strike->count];
+    g->data = NULL;
+    if (size > 0) {
+        g->data = gs_malloc(s->mem, size, 1, "gcache_add");
+        if (g->data == NULL)
+            return;
+        memcpy(g->data, bmg->bitmap.buffer, size);
+    }
+    g->data_owned = true;
+    g->code = a_char_ref->char_codes[0];
+    g->is_glyph_index = a_char_ref->is_glyph_index;
+    g->client_char_code = a_char_ref->client_char_code;
+    g->sb_x = a_char_ref->sb_x;
+    g->sb_y = a_char_ref->sb_y;
+    g->metrics = *a_metrics;
+    g->width = bmg->bitmap.width;
+    g->rows = bmg->bitmap.rows;
+    g->pitch = bmg->bitmap.pitch;
+    g->left = bmg->left;
+    g->top = bmg->top;
+    strike->bytes += size;
+    strike->dirty = true;
+    gcache_insert(strike, strike->count++);
+}
+
+/* Write out the strikes which have new glyphs and free them all. */
+static void
+gcache_finish(ff_server *s)
+{
+    const char *dir = gs_lib_ctx_get_glyph_cache_dir(s->mem);
+
+    while (s->gcache != NULL) {
+        ff_gcache_strike *strike = s->gcache;
+        int i;
+
+        if (strike->dirty && dir != NULL)
+            gcache_write_strike(s, strike, dir);
+        for (i = 0; i < strike->count; i++)
+            if (strike->glyphs[i].data_owned)
+                gs_free(s->mem, strike->glyphs[i].data, 0, 0, "gcache_finish");
+        gs_free(s->mem, strike->glyphs, 0, 0, "gcache_finish");
+        gs_free(s->mem, strike->index, 0, 0, "gcache_finish");
+        gs_free(s->mem, strike->file_data, 0, 0, "gcache_finish");
+        s->gcache = strike->next;
+        gs_free(s->mem, strike, 0, 0, "gcache_finish");
+    }
+}
+
+#endif /* FF_GCACHE */
+
 /*
  * Ensure that the rasterizer is open.
  *
@@ -1402,8 +2043,7 @@ gs_fapi_ft_get_scaled_font(gs_fapi_server * a_server, gs_fapi_font * a_font,
         transform_decompose(&face->ft_transform, &face->horz_res,
                             &face->vert_res, &face->width, &face->height, face->ft_face->units_per_EM);
 
-        ft_error = FT_Set_Char_Size(face->ft_face, face->width, face->height,
-                                    face->horz_res, face->vert_res);
+        ft_error = set_face_size(face);
 
         if (ft_error) {
             /* The code originally cleaned up the face data here, but the "top level"
@@ -1548,10 +2188,20 @@ gs_fapi_ft_get_char_raster_metrics(gs_fapi_server * a_server, gs_fapi_font * a_f
                         gs_fapi_metrics * a_metrics)
 {
     ff_server *s = (ff_server *) a_server;
-    gs_fapi_retcode error =
-        load_glyph(a_server, a_font, a_char_ref, a_metrics,
-                   (FT_Glyph *) & s->bitmap_glyph, true,
-                   a_server->max_bitmap);
+    gs_fapi_retcode error;
+#if FF_GCACHE
+    ff_gcache_strike *strike = gcache_strike(a_server, a_font);
+
+    if (strike != NULL && gcache_lookup(a_server, strike, a_char_ref, a_metrics))
+        return 0;
+#endif
+    error = load_glyph(a_server, a_font, a_char_ref, a_metrics,
+                       (FT_Glyph *) & s->bitmap_glyph, true,
+                       a_server->max_bitmap);
+#if FF_GCACHE
+    if (error == 0 && strike != NULL)
+        gcache_add(a_server, strike, a_char_ref, a_metrics);
+#endif
     return error;
 }
 
@@ -1835,6 +2485,9 @@ gs_fapi_ft_set_mm_weight_vector(gs_fapi_server *server, gs_fapi_font *ff, float
     if (setit == true) {
         ft_error = FT_Set_MM_WeightVector(face->ft_face, length, nwv);
         if (ft_error != 0) return_error(gs_error_invalidaccess);
+        /* Don't trust sizes set up for the previous design */
+        for (i = 0; i < face->num_sizes; i++)
+            face->sizes[i].valid = false;
     }
 
     return 0;
@@ -1919,6 +2572,9 @@ gs_fapi_freetype_destroy(gs_fapi_server ** serv)
     ff_server *server = (ff_server *) * serv;
     gs_memory_t *cmem = server->mem;
 
+#if FF_GCACHE
+    gcache_finish(server);
+#endif
     FT_Done_Glyph(&server->outline_glyph->root);
     FT_Done_Glyph(&server->bitmap_glyph->root);
 
@@ -1795,11 +1795,6 @@ transform_pixel_region_render_portrait(gx_device *dev, gx_default_transform_pixe
                 run += spp;
             }
             /* So we have a run of pixels from data to run that are all the same. */
-            /* This needs to be sped up */
-            for (k = 0; k < spp; k++) {
-                conc[k] = gx_color_value_from_byte(data[k]);
-            }
-            mapper(cmapper);
             /* Fill the region between irun and fixed2int_var_rounded(pnext.x) */
             {
                 int xi = irun;
@@ -1811,9 +1806,16 @@ transform_pixel_region_render_portrait(gx_device *dev, gx_default_transform_pixe
                     wi += xi - minx, xi = minx;
                 if (xi + wi > maxx)
                     wi = maxx - xi;
-                if (wi > 0)
+                /* Runs outside the clip don't need their colour mapping. */
+                if (wi > 0) {
+                    /* This needs to be sped up */
+                    for (k = 0; k < spp; k++) {
+                        conc[k] = gx_color_value_from_byte(data[k]);
+                    }
+                    mapper(cmapper);
                     code = gx_fill_rectangle_device_rop(xi, vci, wi, vdi,
                                                         &cmapper->devc, dev, lop);
+                }
             }
             if (code < 0)
                 goto err;
@@ -1857,11 +1859,6 @@ transform_pixel_region_render_portrait(gx_device *dev, gx_default_transform_pixe
                 run += spp;
             }
             /* So we have a run of pixels from data to run that are all the same. */
-            /* This needs to be sped up */
-            for (k = 0; k < spp; k++) {
-                conc[k] = gx_color_value_from_byte(data[k]);
-            }
-            mapper(cmapper);
             /* Fill the region between irun and fixed2int_var_rounded(pnext.x) */
             {
                 int xi = irun;
@@ -1876,6 +1873,11 @@ transform_pixel_region_render_portrait(gx_device *dev, gx_default_transform_pixe
                     wi = maxx - xi;
 
                 if (wi > 0) {
+                    /* This needs to be sped up */
+                    for (k = 0; k < spp; k++) {
+                        conc[k] = gx_color_value_from_byte(data[k]);
+                    }
+                    mapper(cmapper);
                     if (color_is_pure(&cmapper->devc)) {
                         gx_color_index color = cmapper->devc.colors.pure;
                         int xii = xi * spp;
@@ -1988,11 +1990,6 @@ transform_pixel_region_render_landscape(gx_device *dev, gx_default_transform_pix
             run += spp;
         }
         /* So we have a run of pixels from data to run that are all the same. */
-        /* This needs to be sped up */
-        for (k = 0; k < spp; k++) {
-            conc[k] = gx_color_value_from_byte(data[k]);
-        }
-        mapper(cmapper);
         /* Fill the region between irun and fixed2int_var_rounded(pnext.y) */
         {              /* 90 degree rotated rectangle */
             int yi = irun;
@@ -2004,9 +2001,15 @@ transform_pixel_region_render_landscape(gx_device *dev, gx_default_transform_pix
                 hi += yi - miny, yi = miny;
             if (yi + hi > maxy)
                 hi = maxy - yi;
-            if (hi > 0)
+            if (hi > 0) {
+                /* This needs to be sped up */
+                for (k = 0; k < spp; k++) {
+                    conc[k] = gx_color_value_from_byte(data[k]);
+                }
+                mapper(cmapper);
                 code = gx_fill_rectangle_device_rop(vci, yi, vdi, hi,
                                                     &cmapper->devc, dev, lop);
+            }
         }
         if (code < 0)
             goto err;
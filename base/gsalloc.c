@@ -781,6 +781,7 @@ ialloc_alloc_state(gs_memory_t * parent, uint clump_size)
     iimem->gc_status.max_vm = MAX_MAX_VM;
     iimem->gc_status.signal_value = 0;
     iimem->gc_status.enabled = false;
+    iimem->gc_status.threshold_ratio = 0;
     iimem->gc_status.requested = 0;
     iimem->gc_allocated = 0;
     iimem->previous_status.allocated = 0;
@@ -951,7 +952,10 @@ ialloc_set_limit(register gs_ref_memory_t * mem)
          * The following code is intended to set the limit so that
          * we stop allocating when allocated + previous_status.allocated
          * exceeds the lesser of max_vm or (if GC is enabled)
-         * gc_allocated + vm_threshold.
+         * gc_allocated + vm_threshold.  If threshold_ratio is set, the
+         * interval grows with the amount of VM still in use after the
+         * last GC, so that jobs which keep a lot of data alive don't
+         * spend most of their time retracing it.
          */
     size_t max_allocated =
     (mem->gc_status.max_vm > mem->previous_status.allocated ?
@@ -959,7 +963,17 @@ ialloc_set_limit(register gs_ref_memory_t * mem)
      0);
 
     if (mem->gc_status.enabled) {
-        size_t limit = mem->gc_allocated + mem->gc_status.vm_threshold;
+        size_t threshold = mem->gc_status.vm_threshold;
+        size_t limit;
+
+        if (mem->gc_status.threshold_ratio > 0) {
+            size_t live_threshold =
+                mem->gc_allocated / 100 * mem->gc_status.threshold_ratio;
+
+            if (live_threshold > threshold)
+                threshold = live_threshold;
+        }
+        limit = mem->gc_allocated + threshold;
 
         if (limit < mem->previous_status.allocated)
             mem->limit = 0;
@@ -1104,6 +1118,21 @@ gs_memory_set_vm_reclaim(gs_ref_memory_t * mem, bool enabled)
     gs_memory_set_gc_status(stable, &stat);
 }
 
+/* Set the VM threshold ratio (percentage of VM in use). */
+void
+gs_memory_set_vm_threshold_ratio(gs_ref_memory_t * mem, int val)
+{
+    gs_memory_gc_status_t stat;
+    gs_ref_memory_t * stable = (gs_ref_memory_t *)mem->stable_memory;
+
+    gs_memory_gc_status(mem, &stat);
+    stat.threshold_ratio = val;
+    gs_memory_set_gc_status(mem, &stat);
+    gs_memory_gc_status(stable, &stat);
+    stat.threshold_ratio = val;
+    gs_memory_set_gc_status(stable, &stat);
+}
+
 /* ================ Objects ================ */
 
 /* Allocate a small object quickly if possible. */
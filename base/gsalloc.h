@@ -35,6 +35,8 @@ typedef struct gs_memory_gc_status_s {
 
     int signal_value;		/* value to store in gs_lib_ctx->gcsignal */
     bool enabled;		/* auto GC enabled if true */
+    int threshold_ratio;	/* if > 0, GC interval is at least this */
+                                /* percentage of VM in use after last GC */
         /* Set by allocator */
     size_t requested;		/* amount of last failing request */
 } gs_memory_gc_status_t;
@@ -53,6 +55,7 @@ void gs_memory_set_gc_status(gs_ref_memory_t *, const gs_memory_gc_status_t *);
 /* Value passed as int64_t, but limited to MAX_VM_THRESHOLD (see set_vm_threshold) */
 void gs_memory_set_vm_threshold(gs_ref_memory_t * mem, int64_t val);
 void gs_memory_set_vm_reclaim(gs_ref_memory_t * mem, bool enabled);
+void gs_memory_set_vm_threshold_ratio(gs_ref_memory_t * mem, int val);
 
 /* ------ Initialization ------ */
 
@@ -457,6 +457,7 @@ struct gsicc_link_s {
     gsicc_colorbuffer_t data_cs; /* needed for begin_monitor after end_monitor */
     int num_input;  /* Need so we can monitor properly */
     int num_output; /* Need so we can monitor properly */
+    struct gsicc_row_cache_s *row_cache; /* converted image rows (non-GC) */
 };
 
 /* ICC Cache. The size of the cache is limited by max_memory_size.
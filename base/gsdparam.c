@@ -25,6 +25,7 @@
 #include "gxdevsop.h"
 #include "gxfixed.h"
 #include "gsicc_manage.h"
+#include "gslibctx.h"
 #include "gdevnup.h"		/* to install N-up subclass device */
 extern gx_device_nup gs_nup_device;
 
@@ -87,6 +88,10 @@ int gx_default_get_param(gx_device *dev, char *Param, void *list)
     gsicc_blackptcomp_t blackptcomps[NUM_DEVICE_PROFILES];
     gsicc_blackpreserve_t blackpreserve[NUM_DEVICE_PROFILES];
     int color_accuracy = MAX_COLOR_ACCURACY;
+    int image_color_threads = 0;
+    int image_color_cache_size = 0;
+    int shading_threads = 0;
+    bool shading_function_table = false;
     int depth = dev->color_info.depth;
     cmm_dev_profile_t *dev_profile;
     char null_str[1]={'\0'};
@@ -437,6 +442,26 @@ int gx_default_get_param(gx_device *dev, char *Param, void *list)
     if (strcmp(Param, "ColorAccuracy") == 0) {
         return param_write_int(plist, "ColorAccuracy", (const int *)(&(color_accuracy)));
     }
+    if (strcmp(Param, "ImageColorThreads") == 0) {
+        if (dev->memory != NULL)
+            image_color_threads = gsicc_currentimagethreads(dev->memory);
+        return param_write_int(plist, "ImageColorThreads", &image_color_threads);
+    }
+    if (strcmp(Param, "ImageColorCacheSize") == 0) {
+        if (dev->memory != NULL)
+            image_color_cache_size = (int)gsicc_currentimagecachesize(dev->memory);
+        return param_write_int(plist, "ImageColorCacheSize", &image_color_cache_size);
+    }
+    if (strcmp(Param, "ShadingThreads") == 0) {
+        if (dev->memory != NULL)
+            shading_threads = gs_lib_ctx_get_shading_threads(dev->memory);
+        return param_write_int(plist, "ShadingThreads", &shading_threads);
+    }
+    if (strcmp(Param, "ShadingFunctionTable") == 0) {
+        if (dev->memory != NULL)
+            shading_function_table = gs_lib_ctx_get_shading_function_table(dev->memory);
+        return param_write_bool(plist, "ShadingFunctionTable", &shading_function_table);
+    }
     if (strcmp(Param, "RenderIntent") == 0) {
         return param_write_int(plist,"RenderIntent", (const int *) (&(profile_intents[0])));
     }
@@ -504,6 +529,16 @@ int gx_default_get_param(gx_device *dev, char *Param, void *list)
             param_string_from_string(pagelist, null_str);
         return param_write_string(plist, "PageList", &pagelist);
     }
+    if (strcmp(Param, "GlyphCacheDir") == 0){
+        gs_param_string gcdir;
+        const char *dir = gs_lib_ctx_get_glyph_cache_dir(dev->memory);
+
+        if (dir != NULL)
+            param_string_from_transient_string(gcdir, dir);
+        else
+            param_string_from_string(gcdir, null_str);
+        return param_write_string(plist, "GlyphCacheDir", &gcdir);
+    }
     if (strcmp(Param, "FILTERIMAGE") == 0) {
         temp_bool = dev->ObjectFilter & FILTERIMAGE;
         return param_write_bool(plist, "FILTERIMAGE", &temp_bool);
@@ -544,6 +579,10 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
     bool prebandthreshold = true, temp_bool;
     int k;
     int color_accuracy = MAX_COLOR_ACCURACY;
+    int image_color_threads = 0;
+    int image_color_cache_size = 0;
+    int shading_threads = 0;
+    bool shading_function_table = false;
     gs_param_float_array msa, ibba, hwra, ma;
     gs_param_string_array scna;
     char null_str[1]={'\0'};
@@ -586,6 +625,12 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
     HWSize[1] = dev->height;
     set_param_array(hwsa, HWSize, 2);
     set_param_array(hwma, dev->HWMargins, 4);
+    if (dev->memory != NULL) {
+        image_color_threads = gsicc_currentimagethreads(dev->memory);
+        image_color_cache_size = (int)gsicc_currentimagecachesize(dev->memory);
+        shading_threads = gs_lib_ctx_get_shading_threads(dev->memory);
+        shading_function_table = gs_lib_ctx_get_shading_function_table(dev->memory);
+    }
     /* Check if the device profile is null.  If it is, then we need to
        go ahead and get it set up at this time.  If the proc is not
        set up yet then we are not going to do anything yet */
@@ -727,6 +772,10 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
         (code = param_write_string(plist,"ICCOutputColors", &(icc_colorants))) < 0 ||
         (code = param_write_int(plist, "RenderIntent", (const int *)(&(profile_intents[0])))) < 0 ||
         (code = param_write_int(plist, "ColorAccuracy", (const int *)(&(color_accuracy)))) < 0 ||
+        (code = param_write_int(plist, "ImageColorThreads", &image_color_threads)) < 0 ||
+        (code = param_write_int(plist, "ImageColorCacheSize", &image_color_cache_size)) < 0 ||
+        (code = param_write_int(plist, "ShadingThreads", &shading_threads)) < 0 ||
+        (code = param_write_bool(plist, "ShadingFunctionTable", &shading_function_table)) < 0 ||
         (code = param_write_int(plist,"VectorIntent", (const int *) &(profile_intents[1]))) < 0 ||
         (code = param_write_int(plist,"ImageIntent", (const int *) &(profile_intents[2]))) < 0 ||
         (code = param_write_int(plist,"TextIntent", (const int *) &(profile_intents[3]))) < 0 ||
@@ -808,6 +857,18 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
     if ((code = param_write_string(plist, "PageList", &pagelist)) < 0)
         return code;
 
+    {
+        gs_param_string gcdir;
+        const char *dir = gs_lib_ctx_get_glyph_cache_dir(dev->memory);
+
+        if (dir != NULL)
+            param_string_from_transient_string(gcdir, dir);
+        else
+            param_string_from_string(gcdir, null_str);
+        if ((code = param_write_string(plist, "GlyphCacheDir", &gcdir)) < 0)
+            return code;
+    }
+
     temp_bool = dev->ObjectFilter & FILTERIMAGE;
     if ((code = param_write_bool(plist, "FILTERIMAGE", &temp_bool)) < 0)
         return code;
@@ -1507,10 +1568,14 @@ gx_default_put_params(gx_device * dev, gs_param_list * plist)
     int rend_intent[NUM_DEVICE_PROFILES];
     int blackptcomp[NUM_DEVICE_PROFILES];
     int blackpreserve[NUM_DEVICE_PROFILES];
-    gs_param_string cms, pagelist, nuplist;
+    gs_param_string cms, pagelist, nuplist, gcdir;
     int leadingedge = dev->LeadingEdge;
     int k;
     int color_accuracy;
+    int image_color_threads;
+    int image_color_cache_size;
+    int shading_threads;
+    bool shading_function_table;
     bool devicegraytok = true;
     bool graydetection = false;
     bool usefastcolor = false;
@@ -1525,6 +1590,10 @@ gx_default_put_params(gx_device * dev, gs_param_list * plist)
                                                gsTEXTPROFILE};
 
     color_accuracy = gsicc_currentcoloraccuracy(dev->memory);
+    image_color_threads = gsicc_currentimagethreads(dev->memory);
+    image_color_cache_size = (int)gsicc_currentimagecachesize(dev->memory);
+    shading_threads = gs_lib_ctx_get_shading_threads(dev->memory);
+    shading_function_table = gs_lib_ctx_get_shading_function_table(dev->memory);
     if (dev->icc_struct != NULL) {
         for (k = 0; k < NUM_DEVICE_PROFILES; k++) {
             rend_intent[k] = dev->icc_struct->rendercond[k].rendering_intent;
@@ -1830,6 +1899,35 @@ nce:
         ecode = code;
         param_signal_error(plist, param_name, ecode);
     }
+    if ((code = param_read_int(plist, (param_name = "ImageColorThreads"),
+                                                        &image_color_threads)) < 0) {
+        ecode = code;
+        param_signal_error(plist, param_name, ecode);
+    } else if (image_color_threads < 0) {
+        ecode = gs_note_error(gs_error_rangecheck);
+        param_signal_error(plist, param_name, ecode);
+    }
+    if ((code = param_read_int(plist, (param_name = "ImageColorCacheSize"),
+                                                        &image_color_cache_size)) < 0) {
+        ecode = code;
+        param_signal_error(plist, param_name, ecode);
+    } else if (image_color_cache_size < 0) {
+        ecode = gs_note_error(gs_error_rangecheck);
+        param_signal_error(plist, param_name, ecode);
+    }
+    if ((code = param_read_int(plist, (param_name = "ShadingThreads"),
+                                                        &shading_threads)) < 0) {
+        ecode = code;
+        param_signal_error(plist, param_name, ecode);
+    } else if (shading_threads < 0) {
+        ecode = gs_note_error(gs_error_rangecheck);
+        param_signal_error(plist, param_name, ecode);
+    }
+    if ((code = param_read_bool(plist, (param_name = "ShadingFunctionTable"),
+                                                        &shading_function_table)) < 0) {
+        ecode = code;
+        param_signal_error(plist, param_name, ecode);
+    }
     if ((code = param_read_bool(plist, (param_name = "DeviceGrayToK"),
                                                         &devicegraytok)) < 0) {
         ecode = code;
@@ -2112,6 +2210,16 @@ label:\
         rc_init_free(dev->PageList, dev->memory->non_gc_memory, 1, rc_free_pages_list);
     }
 
+    code = param_read_string(plist, "GlyphCacheDir", &gcdir);
+    if (code < 0)
+        ecode = code;
+    if (code == 0) {
+        code = gs_lib_ctx_set_glyph_cache_dir(dev->memory, (const char *)gcdir.data,
+                                              gcdir.size);
+        if (code < 0)
+            return code;
+    }
+
     code = param_read_bool(plist, "FILTERIMAGE", &temp_bool);
     if (code < 0)
         ecode = code;
@@ -2287,6 +2395,10 @@ label:\
         }
     }
     gsicc_setcoloraccuracy(dev->memory, color_accuracy);
+    gsicc_setimagethreads(dev->memory, image_color_threads);
+    gsicc_setimagecachesize(dev->memory, image_color_cache_size);
+    gs_lib_ctx_set_shading_threads(dev->memory, shading_threads);
+    gs_lib_ctx_set_shading_function_table(dev->memory, shading_function_table);
     code = gx_default_put_graytok(devicegraytok, dev);
     if (code < 0)
         return code;
@@ -67,6 +67,8 @@ static void gsicc_get_buff_hash(unsigned char *data, int64_t *hash, unsigned int
 
 static void rc_gsicc_link_cache_free(gs_memory_t * mem, void *ptr_in, client_name_t cname);
 
+static void gsicc_row_cache_free(gsicc_link_t *link);
+
 /* Structure pointer information */
 
 struct_proc_finalize(icc_link_finalize);
@@ -213,6 +215,7 @@ gsicc_alloc_link_dev(gs_memory_t *memory, cmm_profile_t *src_profile,
     result->is_identity = false;
     result->valid = true;
     result->memory = memory->stable_memory;
+    result->row_cache = NULL;
 
     if_debug1m('^', result->memory, "[^]icclink "PRI_INTPTR" init = 1\n",
                (intptr_t)result);
@@ -295,6 +298,7 @@ gsicc_alloc_link(gs_memory_t *memory, gsicc_hashlink_t hashcode)
     result->is_identity = false;
     result->valid = false;		/* not yet complete */
     result->memory = memory->stable_memory;
+    result->row_cache = NULL;
 
     result->lock = gx_monitor_label(gx_monitor_alloc(memory->stable_memory),
                                     "gsicc_link_new");
@@ -345,6 +349,7 @@ gsicc_set_link_data(gsicc_link_t *icc_link, void *link_handle,
 static void
 gsicc_link_free_contents(gsicc_link_t *icc_link)
 {
+    gsicc_row_cache_free(icc_link);
     icc_link->procs.free_link(icc_link);
     gx_monitor_free(icc_link->lock);
     icc_link->lock = NULL;
@@ -450,6 +455,158 @@ gsicc_get_buff_hash(unsigned char *data, int64_t *hash, unsigned int num_bytes)
     *hash = word1 ^ word2;
 }
 
+/* Cache of converted image rows, hung off a link.  Repeated placements of
+   the same image (or identical rows within one image) are looked up by the
+   source bytes and the output layout, so that the CMS transform is only
+   run once.  The source bytes are kept so that a hash collision can never
+   return the wrong colours.  The total size per link is bounded by
+   -dImageColorCacheSize; the oldest rows are dropped first. */
+#define GSICC_ROW_CACHE_BUCKETS 256
+
+typedef struct gsicc_row_entry_s gsicc_row_entry_t;
+struct gsicc_row_entry_s {
+    gsicc_row_entry_t *next;        /* hash chain */
+    gsicc_row_entry_t *younger;     /* insertion order */
+    uint64_t hash;
+    int layout;
+    uint src_size;
+    uint des_size;
+    /* src_size bytes of source then des_size bytes of output follow */
+};
+
+typedef struct gsicc_row_cache_s {
+    gs_memory_t *memory;
+    size_t max_size;
+    size_t size;
+    gsicc_row_entry_t *oldest;
+    gsicc_row_entry_t *youngest;
+    gsicc_row_entry_t *buckets[GSICC_ROW_CACHE_BUCKETS];
+} gsicc_row_cache_t;
+
+#define ROW_ENTRY_DATA(e) ((byte *)((e) + 1))
+
+/* A cheap word at a time hash; MD5 would cost about as much as the
+   transform we are trying to avoid. */
+uint64_t
+gsicc_row_hash(const byte *data, uint size, int layout)
+{
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)size ^ ((uint64_t)layout << 32);
+    uint64_t w;
+
+    for (; size >= 8; data += 8, size -= 8) {
+        memcpy(&w, data, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    for (; size > 0; data++, size--)
+        h = (h ^ *data) * 0x100000001b3ULL;
+    return h ^ (h >> 32);
+}
+
+bool
+gsicc_row_cache_lookup(gsicc_link_t *link, uint64_t hash, int layout,
+                       const byte *src, uint src_size,
+                       byte *des, uint des_size)
+{
+    gsicc_row_cache_t *cache = link->row_cache;
+    gsicc_row_entry_t *e;
+    bool found = false;
+
+    if (cache == NULL)
+        return false;
+    gx_monitor_enter(link->lock);
+    for (e = cache->buckets[hash % GSICC_ROW_CACHE_BUCKETS]; e != NULL; e = e->next) {
+        if (e->hash == hash && e->layout == layout &&
+            e->src_size == src_size && e->des_size == des_size &&
+            memcmp(ROW_ENTRY_DATA(e), src, src_size) == 0) {
+            memcpy(des, ROW_ENTRY_DATA(e) + src_size, des_size);
+            found = true;
+            break;
+        }
+    }
+    gx_monitor_leave(link->lock);
+    return found;
+}
+
+static void
+gsicc_row_cache_drop_oldest(gsicc_row_cache_t *cache)
+{
+    gsicc_row_entry_t *e = cache->oldest;
+    gsicc_row_entry_t **pprev = &cache->buckets[e->hash % GSICC_ROW_CACHE_BUCKETS];
+
+    while (*pprev != e)
+        pprev = &(*pprev)->next;
+    *pprev = e->next;
+    cache->oldest = e->younger;
+    if (cache->oldest == NULL)
+        cache->youngest = NULL;
+    cache->size -= sizeof(*e) + e->src_size + e->des_size;
+    gs_free_object(cache->memory, e, "gsicc_row_cache_drop_oldest");
+}
+
+void
+gsicc_row_cache_add(gsicc_link_t *link, uint64_t hash, int layout,
+                    const byte *src, uint src_size,
+                    const byte *des, uint des_size)
+{
+    gsicc_row_cache_t *cache;
+    gsicc_row_entry_t *e;
+    size_t entry_size = sizeof(*e) + src_size + des_size;
+    size_t max_size = gsicc_currentimagecachesize(link->memory);
+    gs_memory_t *mem = link->memory->non_gc_memory;
+
+    if (entry_size > max_size)
+        return;
+    gx_monitor_enter(link->lock);
+    cache = link->row_cache;
+    if (cache == NULL) {
+        cache = (gsicc_row_cache_t *)gs_alloc_bytes(mem, sizeof(*cache),
+                                                    "gsicc_row_cache_add");
+        if (cache == NULL)
+            goto done;
+        memset(cache, 0, sizeof(*cache));
+        cache->memory = mem;
+        link->row_cache = cache;
+    }
+    cache->max_size = max_size;
+    while (cache->oldest != NULL && cache->size + entry_size > cache->max_size)
+        gsicc_row_cache_drop_oldest(cache);
+    /* Failing to cache a row is not an error. */
+    e = (gsicc_row_entry_t *)gs_alloc_bytes(mem, entry_size, "gsicc_row_cache_add");
+    if (e == NULL)
+        goto done;
+    e->hash = hash;
+    e->layout = layout;
+    e->src_size = src_size;
+    e->des_size = des_size;
+    memcpy(ROW_ENTRY_DATA(e), src, src_size);
+    memcpy(ROW_ENTRY_DATA(e) + src_size, des, des_size);
+    e->next = cache->buckets[hash % GSICC_ROW_CACHE_BUCKETS];
+    cache->buckets[hash % GSICC_ROW_CACHE_BUCKETS] = e;
+    e->younger = NULL;
+    if (cache->youngest != NULL)
+        cache->youngest->younger = e;
+    else
+        cache->oldest = e;
+    cache->youngest = e;
+    cache->size += entry_size;
+done:
+    gx_monitor_leave(link->lock);
+}
+
+static void
+gsicc_row_cache_free(gsicc_link_t *link)
+{
+    gsicc_row_cache_t *cache = link->row_cache;
+
+    if (cache == NULL)
+        return;
+    while (cache->oldest != NULL)
+        gsicc_row_cache_drop_oldest(cache);
+    gs_free_object(cache->memory, cache, "gsicc_row_cache_free");
+    link->row_cache = NULL;
+}
+
 /* Compute a hash code for the current transformation case.
     This just computes a 64bit xor of upper and lower portions of
     md5 for the input, output
@@ -67,4 +67,11 @@ int  gsicc_get_device_profile_comps(const cmm_dev_profile_t *dev_profile);
 gsicc_link_t * gsicc_alloc_link_dev(gs_memory_t *memory, cmm_profile_t *src_profile,
     cmm_profile_t *des_profile, gsicc_rendering_param_t *rendering_params);
 void gsicc_free_link_dev(gs_memory_t *memory, gsicc_link_t *link);
+uint64_t gsicc_row_hash(const byte *data, uint size, int layout);
+bool gsicc_row_cache_lookup(gsicc_link_t *link, uint64_t hash, int layout,
+                            const byte *src, uint src_size,
+                            byte *des, uint des_size);
+void gsicc_row_cache_add(gsicc_link_t *link, uint64_t hash, int layout,
+                         const byte *src, uint src_size,
+                         const byte *des, uint des_size);
 #endif
@@ -128,6 +128,38 @@ gsicc_currentcoloraccuracy(gs_memory_t *mem)
     return ctx->icc_color_accuracy;
 }
 
+void
+gsicc_setimagethreads(gs_memory_t *mem, uint num_threads)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    ctx->icc_image_threads = num_threads;
+}
+
+uint
+gsicc_currentimagethreads(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return ctx->icc_image_threads;
+}
+
+void
+gsicc_setimagecachesize(gs_memory_t *mem, size_t size)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    ctx->icc_image_cache_size = size;
+}
+
+size_t
+gsicc_currentimagecachesize(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return ctx->icc_image_cache_size;
+}
+
 /* Get the size of the ICC profile that is in the buffer */
 unsigned int
 gsicc_getprofilesize(unsigned char *buffer)
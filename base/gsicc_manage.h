@@ -161,6 +161,10 @@ int gs_setlabicc(const gs_gstate * pgs, gs_param_string * pval);
 int gsicc_get_device_class(cmm_profile_t *icc_profile);
 uint gsicc_currentcoloraccuracy(gs_memory_t *mem);
 void gsicc_setcoloraccuracy(gs_memory_t *mem, uint level);
+uint gsicc_currentimagethreads(gs_memory_t *mem);
+void gsicc_setimagethreads(gs_memory_t *mem, uint num_threads);
+size_t gsicc_currentimagecachesize(gs_memory_t *mem);
+void gsicc_setimagecachesize(gs_memory_t *mem, size_t size);
 
 #if ICC_DUMP
 static void dump_icc_buffer(const gs_memory_t *mem, int buffersize, char filename[],byte *Buffer);
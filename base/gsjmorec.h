@@ -34,7 +34,6 @@
  */
 
 #undef BLOCK_SMOOTHING_SUPPORTED
-#undef IDCT_SCALING_SUPPORTED
 #undef UPSAMPLE_SCALING_SUPPORTED
 #undef UPSAMPLE_MERGING_SUPPORTED
 #undef QUANT_1PASS_SUPPORTED
@@ -45,4 +44,12 @@
  */
 #define D_MAX_BLOCKS_IN_MCU   64
 
+/*
+ * IDCT scaling is kept for decoding at reduced size (see ScaleDenom in
+ * sdct.h). It also lets the library upsample chroma in the DCT domain,
+ * which would change full size output, so the DCTDecode filter turns
+ * do_fancy_upsampling off when it sees this.
+ */
+#define GS_JPEG_BOX_UPSAMPLING
+
 #endif /* gsjmorec_INCLUDED */
@@ -355,6 +355,11 @@ int gs_lib_ctx_init(gs_lib_ctx_t *ctx, gs_memory_t *mem)
     pio->profiledir = NULL;
     pio->profiledir_len = 0;
     pio->icc_color_accuracy = MAX_COLOR_ACCURACY;
+    pio->icc_image_threads = 0;
+    pio->icc_image_cache_size = 0;
+    pio->shading_threads = 0;
+    pio->shading_function_table = false;
+    pio->glyph_cache_dir = NULL;
     if (gs_lib_ctx_set_icc_directory(mem, DEFAULT_DIR_ICC, strlen(DEFAULT_DIR_ICC)) < 0)
       goto Failure;
 
@@ -420,6 +425,8 @@ void gs_lib_ctx_fin(gs_memory_t *mem)
     gscms_destroy(ctx_mem);
     gs_free_object(ctx_mem, ctx->profiledir,
         "gs_lib_ctx_fin");
+    gs_free_object(ctx_mem, ctx->glyph_cache_dir,
+        "gs_lib_ctx_fin");
 
     gs_free_object(ctx_mem, ctx->default_device_list,
                 "gs_lib_ctx_fin");
@@ -494,6 +501,66 @@ int gs_lib_ctx_get_act_on_uel( const gs_memory_t *mem )
     return mem->gs_lib_ctx->core->act_on_uel;
 }
 
+void gs_lib_ctx_set_shading_threads( const gs_memory_t *mem, uint num_threads )
+{
+    if (mem == NULL)
+        return;
+    mem->gs_lib_ctx->shading_threads = num_threads;
+}
+
+uint gs_lib_ctx_get_shading_threads( const gs_memory_t *mem )
+{
+    if (mem == NULL)
+        return 0;
+    return mem->gs_lib_ctx->shading_threads;
+}
+
+void gs_lib_ctx_set_shading_function_table( const gs_memory_t *mem, bool on )
+{
+    if (mem == NULL)
+        return;
+    mem->gs_lib_ctx->shading_function_table = on;
+}
+
+bool gs_lib_ctx_get_shading_function_table( const gs_memory_t *mem )
+{
+    if (mem == NULL)
+        return false;
+    return mem->gs_lib_ctx->shading_function_table;
+}
+
+/* An empty string turns the glyph cache off. */
+int gs_lib_ctx_set_glyph_cache_dir( const gs_memory_t *mem, const char *dir, int len )
+{
+    gs_lib_ctx_t *p_ctx = mem->gs_lib_ctx;
+    char *result = NULL;
+
+    if (p_ctx->glyph_cache_dir != NULL && strlen(p_ctx->glyph_cache_dir) == (size_t)len &&
+        strncmp(dir, p_ctx->glyph_cache_dir, len) == 0)
+        return 0;
+    if (p_ctx->glyph_cache_dir == NULL && len == 0)
+        return 0;
+    if (len > 0) {
+        result = (char *)gs_alloc_bytes(p_ctx->memory, len + 1,
+                                        "gs_lib_ctx_set_glyph_cache_dir");
+        if (result == NULL)
+            return_error(gs_error_VMerror);
+        memcpy(result, dir, len);
+        result[len] = 0;
+    }
+    gs_free_object(p_ctx->memory, p_ctx->glyph_cache_dir,
+                   "gs_lib_ctx_set_glyph_cache_dir");
+    p_ctx->glyph_cache_dir = result;
+    return 0;
+}
+
+const char *gs_lib_ctx_get_glyph_cache_dir( const gs_memory_t *mem )
+{
+    if (mem == NULL)
+        return NULL;
+    return mem->gs_lib_ctx->glyph_cache_dir;
+}
+
 /* Provide a single point for all "C" stdout and stderr.
  */
 
@@ -168,6 +168,16 @@ typedef struct gs_lib_ctx_s
     uint screen_min_screen_levels;
     /* Accuracy vs. performance for ICC color */
     uint icc_color_accuracy;
+    /* Number of threads used to colour convert large images (0 = off) */
+    uint icc_image_threads;
+    /* Bytes of converted image rows cached per ICC link (0 = off) */
+    size_t icc_image_cache_size;
+    /* Number of threads used to fill mesh and patch shadings (0 = off) */
+    uint shading_threads;
+    /* Interpolate axial and radial shading functions from samples */
+    bool shading_function_table;
+    /* Directory of the persistent FreeType glyph cache (NULL = off) */
+    char *glyph_cache_dir;
     /* real time clock 'bias' value. Not strictly required, but some FTS
      * tests work better if realtime starts from 0 at boot time. */
     long real_time_0[2];
@@ -212,6 +222,12 @@ gs_lib_ctx_t *gs_lib_ctx_get_interp_instance( const gs_memory_t *mem );
 void *gs_lib_ctx_get_cms_context( const gs_memory_t *mem );
 void gs_lib_ctx_set_cms_context( const gs_memory_t *mem, void *cms_context );
 int gs_lib_ctx_get_act_on_uel( const gs_memory_t *mem );
+void gs_lib_ctx_set_shading_threads( const gs_memory_t *mem, uint num_threads );
+uint gs_lib_ctx_get_shading_threads( const gs_memory_t *mem );
+void gs_lib_ctx_set_shading_function_table( const gs_memory_t *mem, bool on );
+bool gs_lib_ctx_get_shading_function_table( const gs_memory_t *mem );
+int gs_lib_ctx_set_glyph_cache_dir( const gs_memory_t *mem, const char *dir, int len );
+const char *gs_lib_ctx_get_glyph_cache_dir( const gs_memory_t *mem );
 
 int gs_lib_ctx_register_callout(gs_memory_t *mem, gs_callout_fn, void *arg);
 void gs_lib_ctx_deregister_callout(gs_memory_t *mem, gs_callout_fn, void *arg);
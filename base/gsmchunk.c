@@ -161,12 +161,35 @@ typedef struct chunk_slab_s {
     struct chunk_slab_s *next;
 } chunk_slab_t;
 
+/*
+ * Small freed objects are kept on per-size-class lists (linked through
+ * defer_next) rather than being merged back into the free trees, so that
+ * the common pattern of freeing and reallocating objects of the same size
+ * doesn't splay both trees each time.  Block sizes are multiples of
+ * obj_align_mod, and class n holds only blocks of exactly n * obj_align_mod
+ * bytes, so any block on the list a request maps to is the right size.  The
+ * lists are flushed back into the trees before we allocate another slab,
+ * and by consolidate_free.  Since every thread has its own chunk allocator,
+ * these act as per-thread caches.
+ */
+#define CHUNK_NUM_CLASSES 128
+#define CHUNK_CLASS(size) ((size) >> log2_obj_align_mod)
+
 typedef struct gs_memory_chunk_s {
     gs_memory_common;           /* interface outside world sees */
     gs_memory_t *target;        /* base allocator */
     chunk_slab_t *slabs;         /* list of slabs for freeing */
     chunk_free_node_t *free_size;/* free tree */
     chunk_free_node_t *free_loc; /* free tree */
+    chunk_obj_node_t *free_class[CHUNK_NUM_CLASSES]; /* small free lists */
+    size_t class_free;          /* total size of blocks on free_class */
+#ifdef DEBUG
+    /* Allocation histogram: requests per size class, then the ones
+     * served from the trees, then the single object chunks. */
+    ulong class_allocs[CHUNK_NUM_CLASSES];
+    ulong tree_allocs;
+    ulong single_allocs;
+#endif
     chunk_obj_node_t *defer_finalize_list;
     chunk_obj_node_t *defer_free_list;
     size_t used;
@@ -208,6 +231,13 @@ gs_memory_chunk_wrap(gs_memory_t **wrapped,      /* chunk allocator init */
     cmem->slabs = NULL;
     cmem->free_size = NULL;
     cmem->free_loc = NULL;
+    memset(cmem->free_class, 0, sizeof(cmem->free_class));
+    cmem->class_free = 0;
+#ifdef DEBUG
+    memset(cmem->class_allocs, 0, sizeof(cmem->class_allocs));
+    cmem->tree_allocs = 0;
+    cmem->single_allocs = 0;
+#endif
     cmem->used = 0;
     cmem->max_used = 0;
     cmem->total_free = 0;
@@ -284,16 +314,40 @@ chunk_mem_node_free_all_slabs(gs_memory_chunk_t *cmem)
     cmem->slabs = NULL;
     cmem->free_size = NULL;
     cmem->free_loc = NULL;
+    memset(cmem->free_class, 0, sizeof(cmem->free_class));
+    cmem->class_free = 0;
     cmem->total_free = 0;
     cmem->used = 0;
 }
 
+#ifdef DEBUG
+static void
+chunk_print_histogram(gs_memory_chunk_t *cmem)
+{
+    int i;
+
+    dmlprintf1(cmem->target, "[a]chunk "PRI_INTPTR" allocations by size:\n",
+               (intptr_t)cmem);
+    for (i = 1; i < CHUNK_NUM_CLASSES; i++)
+        if (cmem->class_allocs[i] != 0)
+            dmlprintf2(cmem->target, "[a]  %5u: %lu\n",
+                       (uint)(i * obj_align_mod),
+                       cmem->class_allocs[i]);
+    dmlprintf2(cmem->target, "[a]  larger: %lu, single object: %lu\n",
+               cmem->tree_allocs, cmem->single_allocs);
+}
+#endif
+
 static void
 chunk_free_all(gs_memory_t * mem, uint free_mask, client_name_t cname)
 {
     gs_memory_chunk_t * const cmem = (gs_memory_chunk_t *)mem;
     gs_memory_t * const target = cmem->target;
 
+#ifdef DEBUG
+    if (gs_debug_c('a') && (free_mask & FREE_ALL_DATA))
+        chunk_print_histogram(cmem);
+#endif
     if (free_mask & FREE_ALL_DATA)
         chunk_mem_node_free_all_slabs(cmem);
     /* Only free the structures and the allocator itself. */
@@ -401,9 +455,9 @@ gs_memory_chunk_dump_memory(const gs_memory_t *mem)
         dmlprintf2(cmem->target, "Tree mismatch! %d vs %d\n", count1, count2);
         crash();
     }
-    if (total != cmem->total_free) {
+    if (total + cmem->class_free != cmem->total_free) {
         void (*crash)(void) = NULL;
-        dmlprintf2(cmem->target, "Free size mismatch! %u vs %lu\n", total, cmem->total_free);
+        dmlprintf2(cmem->target, "Free size mismatch! %u vs %lu\n", total, cmem->total_free - cmem->class_free);
         crash();
     }
 }
@@ -753,13 +807,133 @@ static void remove_free(gs_memory_chunk_t *cmem, chunk_free_node_t *node)
 #define SINGLE_OBJECT_CHUNK(size) ((size) > (CHUNK_SIZE>>1))
 #endif
 
+static void chunk_flush_classes(gs_memory_chunk_t *cmem);
+
+/* Find the smallest free block in the size tree that is large enough,
+ * returning the address of the pointer to it, or NULL. */
+static chunk_free_node_t **
+chunk_find_free(gs_memory_chunk_t *cmem, size_t newsize)
+{
+    chunk_free_node_t **ap, **okp;
+    chunk_free_node_t  *a, *b, *c;
+
+    /* Find the smallest free block that's large enough */
+    /* okp points to the parent pointer to the block we pick */
+    ap = &cmem->free_size;
+    okp = NULL;
+    while ((a = *ap) != NULL) {
+        if (a->size >= newsize) {
+            b = a->left_size;
+            if (b == NULL) {
+                okp = ap; /* a will do */
+                break; /* Stop searching */
+            }
+            if (b->size >= newsize) {
+                c = b->left_size;
+                if (c == NULL) {
+                    okp = &a->left_size; /* b is as good as we're going to get */
+                    break;
+                }
+                /* Splay:        a             c
+                 *            b     Z   =>  W     b
+                 *          c   Y               X   a
+                 *         W X                     Y Z
+                 */
+                *ap = c;
+                a->left_size  = b->right_size;
+                b->left_size  = c->right_size;
+                b->right_size = a;
+                c->right_size = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &c->left_size;
+                } else {
+                    okp = &c->right_size; /* b is the best so far */
+                    ap = &b->left_size;
+                }
+            } else {
+                c = b->right_size;
+                if (c == NULL) {
+                    okp = ap; /* a is as good as we are going to get */
+                    break;
+                }
+                /* Splay:         a             c
+                 *            b       Z  =>   b   a
+                 *          W   c            W X Y Z
+                 *             X Y
+                 */
+                *ap = c;
+                a->left_size  = c->right_size;
+                b->right_size = c->left_size;
+                c->left_size  = b;
+                c->right_size = a;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &b->right_size;
+                } else {
+                    okp = &c->right_size; /* a is the best so far */
+                    ap = &a->left_size;
+                }
+            }
+        } else {
+            b = a->right_size;
+            if (b == NULL)
+                break; /* No better match to be found */
+            if (b->size >= newsize) {
+                c = b->left_size;
+                if (c == NULL) {
+                    okp = &a->right_size; /* b is as good as we're going to get */
+                    break;
+                }
+                /* Splay:      a                c
+                 *         W       b    =>    a   b
+                 *               c   Z       W X Y Z
+                 *              X Y
+                 */
+                *ap = c;
+                a->right_size = c->left_size;
+                b->left_size  = c->right_size;
+                c->left_size  = a;
+                c->right_size = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &a->right_size;
+                } else {
+                    okp = &c->right_size; /* b is the best so far */
+                    ap = &b->left_size;
+                }
+            } else {
+                c = b->right_size;
+                if (c == NULL)
+                    break; /* No better match to be found */
+                /* Splay:    a                   c
+                 *        W     b      =>     b     Z
+                 *            X   c         a   Y
+                 *               Y Z       W X
+                 */
+                *ap = c;
+                a->right_size = b->left_size;
+                b->right_size = c->left_size;
+                b->left_size  = a;
+                c->left_size  = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &b->right_size;
+                } else
+                    ap = &c->right_size;
+            }
+        }
+    }
+
+    return okp;
+}
+
 /* All of the allocation routines reduce to this function */
 static byte *
 chunk_obj_alloc(gs_memory_t *mem, size_t size, gs_memory_type_ptr_t type, client_name_t cname)
 {
     gs_memory_chunk_t  *cmem = (gs_memory_chunk_t *)mem;
-    chunk_free_node_t **ap, **okp;
-    chunk_free_node_t  *a, *b, *c;
+    chunk_free_node_t **okp;
     size_t newsize;
     chunk_obj_node_t *obj = NULL;
 
@@ -791,150 +965,73 @@ chunk_obj_alloc(gs_memory_t *mem, size_t size, gs_memory_type_ptr_t type, client
         obj = (chunk_obj_node_t *)gs_alloc_bytes_immovable(cmem->target, newsize, cname);
         if (obj == NULL)
             return NULL;
+#ifdef DEBUG
+        cmem->single_allocs++;
+#endif
     } else {
-        /* Find the smallest free block that's large enough */
-        /* okp points to the parent pointer to the block we pick */
-        ap = &cmem->free_size;
-        okp = NULL;
-        while ((a = *ap) != NULL) {
-            if (a->size >= newsize) {
-                b = a->left_size;
-                if (b == NULL) {
-                    okp = ap; /* a will do */
-                    break; /* Stop searching */
-                }
-                if (b->size >= newsize) {
-                    c = b->left_size;
-                    if (c == NULL) {
-                        okp = &a->left_size; /* b is as good as we're going to get */
-                        break;
-                    }
-                    /* Splay:        a             c
-                     *            b     Z   =>  W     b
-                     *          c   Y               X   a
-                     *         W X                     Y Z
-                     */
-                    *ap = c;
-                    a->left_size  = b->right_size;
-                    b->left_size  = c->right_size;
-                    b->right_size = a;
-                    c->right_size = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &c->left_size;
-                    } else {
-                        okp = &c->right_size; /* b is the best so far */
-                        ap = &b->left_size;
-                    }
-                } else {
-                    c = b->right_size;
-                    if (c == NULL) {
-                        okp = ap; /* a is as good as we are going to get */
-                        break;
-                    }
-                    /* Splay:         a             c
-                     *            b       Z  =>   b   a
-                     *          W   c            W X Y Z
-                     *             X Y
-                     */
-                    *ap = c;
-                    a->left_size  = c->right_size;
-                    b->right_size = c->left_size;
-                    c->left_size  = b;
-                    c->right_size = a;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &b->right_size;
-                    } else {
-                        okp = &c->right_size; /* a is the best so far */
-                        ap = &a->left_size;
-                    }
+        size_t cls = CHUNK_CLASS(newsize);
+
+        if (cls < CHUNK_NUM_CLASSES && cmem->free_class[cls] != NULL) {
+            /* Reuse a recently freed block of the same size class */
+            obj = cmem->free_class[cls];
+            cmem->free_class[cls] = obj->defer_next;
+            newsize = obj->size;
+            cmem->class_free -= newsize;
+            cmem->total_free -= newsize;
+#ifdef DEBUG
+            cmem->class_allocs[cls]++;
+#endif
+        } else {
+#ifdef DEBUG
+            if (cls < CHUNK_NUM_CLASSES)
+                cmem->class_allocs[cls]++;
+            else
+                cmem->tree_allocs++;
+#endif
+            okp = chunk_find_free(cmem, newsize);
+            if (okp == NULL && cmem->class_free != 0) {
+                /* Give the small free lists back to the trees before
+                 * growing, so that their space can be merged and reused. */
+                chunk_flush_classes(cmem);
+                okp = chunk_find_free(cmem, newsize);
+            }
+
+            /* So *okp points to the most appropriate free tree entry. */
+
+            if (okp == NULL) {
+                /* No appropriate free space slot. We need to allocate a new slab. */
+                chunk_slab_t *slab;
+                uint slab_size = newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t);
+                if (slab_size <= (CHUNK_SIZE>>1))
+                    slab_size = CHUNK_SIZE;
+                slab = (chunk_slab_t *)gs_alloc_bytes_immovable(cmem->target, slab_size, cname);
+                if (slab == NULL)
+                    return NULL;
+                slab->next = cmem->slabs;
+                cmem->slabs = slab;
+
+                obj = (chunk_obj_node_t *)(((byte *)slab) + SIZEOF_ROUND_ALIGN(chunk_slab_t));
+                if (slab_size != newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t)) {
+                    insert_free(cmem, (chunk_free_node_t *)(((byte *)obj)+newsize), slab_size - newsize - SIZEOF_ROUND_ALIGN(chunk_slab_t));
+                    cmem->total_free += slab_size - newsize - SIZEOF_ROUND_ALIGN(chunk_slab_t);
                 }
             } else {
-                b = a->right_size;
-                if (b == NULL)
-                    break; /* No better match to be found */
-                if (b->size >= newsize) {
-                    c = b->left_size;
-                    if (c == NULL) {
-                        okp = &a->right_size; /* b is as good as we're going to get */
-                        break;
-                    }
-                    /* Splay:      a                c
-                     *         W       b    =>    a   b
-                     *               c   Z       W X Y Z
-                     *              X Y
-                     */
-                    *ap = c;
-                    a->right_size = c->left_size;
-                    b->left_size  = c->right_size;
-                    c->left_size  = a;
-                    c->right_size = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &a->right_size;
-                    } else {
-                        okp = &c->right_size; /* b is the best so far */
-                        ap = &b->left_size;
-                    }
+                chunk_free_node_t *ok = *okp;
+                obj = (chunk_obj_node_t *)(void *)ok;
+                if (ok->size >= newsize + SIZEOF_ROUND_ALIGN(chunk_free_node_t)) {
+                    chunk_free_node_t *tail = (chunk_free_node_t *)(((byte *)ok) + newsize);
+                    uint tail_size = ok->size - newsize;
+                    remove_free_size_fast(cmem, okp);
+                    remove_free_loc(cmem, ok);
+                    insert_free(cmem, tail, tail_size);
                 } else {
-                    c = b->right_size;
-                    if (c == NULL)
-                        break; /* No better match to be found */
-                    /* Splay:    a                   c
-                     *        W     b      =>     b     Z
-                     *            X   c         a   Y
-                     *               Y Z       W X
-                     */
-                    *ap = c;
-                    a->right_size = b->left_size;
-                    b->right_size = c->left_size;
-                    b->left_size  = a;
-                    c->left_size  = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &b->right_size;
-                    } else
-                        ap = &c->right_size;
+                    newsize = ok->size;
+                    remove_free_size_fast(cmem, okp);
+                    remove_free_loc(cmem, ok);
                 }
+                cmem->total_free -= newsize;
             }
         }
-
-        /* So *okp points to the most appropriate free tree entry. */
-
-        if (okp == NULL) {
-            /* No appropriate free space slot. We need to allocate a new slab. */
-            chunk_slab_t *slab;
-            uint slab_size = newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t);
-            if (slab_size <= (CHUNK_SIZE>>1))
-                slab_size = CHUNK_SIZE;
-            slab = (chunk_slab_t *)gs_alloc_bytes_immovable(cmem->target, slab_size, cname);
-            if (slab == NULL)
-                return NULL;
-            slab->next = cmem->slabs;
-            cmem->slabs = slab;
-
-            obj = (chunk_obj_node_t *)(((byte *)slab) + SIZEOF_ROUND_ALIGN(chunk_slab_t));
-            if (slab_size != newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t)) {
-                insert_free(cmem, (chunk_free_node_t *)(((byte *)obj)+newsize), slab_size - newsize - SIZEOF_ROUND_ALIGN(chunk_slab_t));
-                cmem->total_free += slab_size - newsize - SIZEOF_ROUND_ALIGN(chunk_slab_t);
-            }
-        } else {
-            chunk_free_node_t *ok = *okp;
-            obj = (chunk_obj_node_t *)(void *)ok;
-            if (ok->size >= newsize + SIZEOF_ROUND_ALIGN(chunk_free_node_t)) {
-                chunk_free_node_t *tail = (chunk_free_node_t *)(((byte *)ok) + newsize);
-                uint tail_size = ok->size - newsize;
-                remove_free_size_fast(cmem, okp);
-                remove_free_loc(cmem, ok);
-                insert_free(cmem, tail, tail_size);
-            } else {
-                newsize = ok->size;
-                remove_free_size_fast(cmem, okp);
-                remove_free_loc(cmem, ok);
-            }
-            cmem->total_free -= newsize;
-        }
     }
 
     if (gs_alloc_debug) {
@@ -1053,62 +1150,13 @@ chunk_resize_object(gs_memory_t * mem, void *ptr, size_t new_num_elements, clien
     return new_ptr;
 }
 
+/* Return a block to the free trees, merging it with its neighbours. */
 static void
-chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
+chunk_free_to_tree(gs_memory_chunk_t *cmem, chunk_obj_node_t *obj)
 {
-    gs_memory_chunk_t * const cmem = (gs_memory_chunk_t *)mem;
-    size_t obj_node_size;
-    chunk_obj_node_t *obj;
-    struct_proc_finalize((*finalize));
     chunk_free_node_t **ap, **gtp, **ltp;
     chunk_free_node_t *a, *b, *c;
 
-    if (ptr == NULL)
-        return;
-
-    /* back up to obj header */
-    obj_node_size = SIZEOF_ROUND_ALIGN(chunk_obj_node_t);
-    obj = (chunk_obj_node_t *)(((byte *)ptr) - obj_node_size);
-
-    if (cmem->deferring) {
-        if (obj->defer_next == NULL) {
-            obj->defer_next = cmem->defer_finalize_list;
-            cmem->defer_finalize_list = obj;
-        }
-        return;
-    }
-
-#ifdef DEBUG_CHUNK_PRINT
-#ifdef DEBUG_SEQ
-    cmem->sequence++;
-    dmlprintf6(cmem->target, "Event %x: free(chunk="PRI_INTPTR", addr="PRI_INTPTR", size=%x, num=%x, cname=%s)\n",
-               cmem->sequence, (intptr_t)cmem, (intptr_t)obj, obj->size, obj->sequence, cname);
-#else
-    dmlprintf4(cmem->target, "free(chunk="PRI_INTPTR", addr="PRI_INTPTR", size=%x, cname=%s)\n",
-               (intptr_t)cmem, (intptr_t)obj, obj->size, cname);
-#endif
-#endif
-
-    if (obj->type) {
-        finalize = obj->type->finalize;
-        if (finalize != NULL)
-            finalize(mem, ptr);
-    }
-    /* finalize may change the head_**_chunk doing free of stuff */
-
-    if_debug3m('A', cmem->target, "[a-]chunk_free_object(%s) "PRI_INTPTR"(%"PRIuSIZE")\n",
-               client_name_string(cname), (intptr_t)ptr, obj->size);
-
-    cmem->used -= obj->size;
-
-    if (SINGLE_OBJECT_CHUNK(obj->size - obj->padding)) {
-        gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
-#ifdef DEBUG_CHUNK
-        gs_memory_chunk_dump_memory(cmem);
-#endif
-        return;
-    }
-
     /* We want to find where to insert this free entry into our free tree. We need to know
      * both the point to the left of it, and the point to the right of it, in order to see
      * if we can merge the free entries. Accordingly, we search from the top of the tree
@@ -1302,6 +1350,95 @@ chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
         if (gs_alloc_debug)
             memset(((byte *)objfree) + SIZEOF_ROUND_ALIGN(chunk_free_node_t), 0x9b, objfree->size - SIZEOF_ROUND_ALIGN(chunk_free_node_t));
     }
+}
+
+/* Move everything on the small free lists back into the trees. */
+static void
+chunk_flush_classes(gs_memory_chunk_t *cmem)
+{
+    int i;
+
+    for (i = 0; i < CHUNK_NUM_CLASSES; i++) {
+        chunk_obj_node_t *obj = cmem->free_class[i];
+
+        while (obj != NULL) {
+            chunk_obj_node_t *next = obj->defer_next;
+
+            /* chunk_free_to_tree adds it to total_free again */
+            cmem->total_free -= obj->size;
+            chunk_free_to_tree(cmem, obj);
+            obj = next;
+        }
+        cmem->free_class[i] = NULL;
+    }
+    cmem->class_free = 0;
+}
+
+static void
+chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
+{
+    gs_memory_chunk_t * const cmem = (gs_memory_chunk_t *)mem;
+    size_t obj_node_size;
+    chunk_obj_node_t *obj;
+    struct_proc_finalize((*finalize));
+    size_t cls;
+
+    if (ptr == NULL)
+        return;
+
+    /* back up to obj header */
+    obj_node_size = SIZEOF_ROUND_ALIGN(chunk_obj_node_t);
+    obj = (chunk_obj_node_t *)(((byte *)ptr) - obj_node_size);
+
+    if (cmem->deferring) {
+        if (obj->defer_next == NULL) {
+            obj->defer_next = cmem->defer_finalize_list;
+            cmem->defer_finalize_list = obj;
+        }
+        return;
+    }
+
+#ifdef DEBUG_CHUNK_PRINT
+#ifdef DEBUG_SEQ
+    cmem->sequence++;
+    dmlprintf6(cmem->target, "Event %x: free(chunk="PRI_INTPTR", addr="PRI_INTPTR", size=%x, num=%x, cname=%s)\n",
+               cmem->sequence, (intptr_t)cmem, (intptr_t)obj, obj->size, obj->sequence, cname);
+#else
+    dmlprintf4(cmem->target, "free(chunk="PRI_INTPTR", addr="PRI_INTPTR", size=%x, cname=%s)\n",
+               (intptr_t)cmem, (intptr_t)obj, obj->size, cname);
+#endif
+#endif
+
+    if (obj->type) {
+        finalize = obj->type->finalize;
+        if (finalize != NULL)
+            finalize(mem, ptr);
+    }
+    /* finalize may change the head_**_chunk doing free of stuff */
+
+    if_debug3m('A', cmem->target, "[a-]chunk_free_object(%s) "PRI_INTPTR"(%"PRIuSIZE")\n",
+               client_name_string(cname), (intptr_t)ptr, obj->size);
+
+    cmem->used -= obj->size;
+
+    if (SINGLE_OBJECT_CHUNK(obj->size - obj->padding)) {
+        gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
+#ifdef DEBUG_CHUNK
+        gs_memory_chunk_dump_memory(cmem);
+#endif
+        return;
+    }
+
+    cls = CHUNK_CLASS(obj->size);
+    if (cls < CHUNK_NUM_CLASSES) {
+        obj->defer_next = cmem->free_class[cls];
+        cmem->free_class[cls] = obj;
+        cmem->class_free += obj->size;
+        cmem->total_free += obj->size;
+        if (gs_alloc_debug)
+            memset(((byte *)obj) + obj_node_size, 0x9b, obj->size - obj_node_size);
+    } else
+        chunk_free_to_tree(cmem, obj);
 
 #ifdef DEBUG_CHUNK
     gs_memory_chunk_dump_memory(cmem);
@@ -1403,6 +1540,9 @@ static void chunk_defer_frees(gs_memory_t *mem, int defer)
 static void
 chunk_consolidate_free(gs_memory_t *mem)
 {
+    gs_memory_chunk_t *cmem = (gs_memory_chunk_t *)mem;
+
+    chunk_flush_classes(cmem);
 }
 
 /* accessors to get size and type given the pointer returned to the client */
@@ -178,6 +178,66 @@ gx_make_clip_device_on_stack_if_needed(gx_device_clip * dev, const gx_clip_path
     (*dev_proc(dev, open_device)) ((gx_device *)dev);
     return (gx_device *)dev;
 }
+/*
+ * Make a clipping device on the stack that clips to the same region as an
+ * existing one.  The clip list is shared and must not change while the copy
+ * is in use, but the list cursor is not, so the original and the copy can
+ * be drawn through from different threads.
+ */
+void
+gx_make_clip_device_copy_on_stack(gx_device_clip * dev, const gx_device_clip *src)
+{
+    gx_device *target = src->target;
+
+    gx_device_init_on_stack((gx_device *)dev, (const gx_device *)&gs_clip_device, target->memory);
+    dev->list = src->list;
+    dev->translation = src->translation;
+    dev->HWResolution[0] = src->HWResolution[0];
+    dev->HWResolution[1] = src->HWResolution[1];
+    dev->sgr = src->sgr;
+    dev->target = target;
+    dev->pad = src->pad;
+    dev->log2_align_mod = src->log2_align_mod;
+    dev->is_planar = src->is_planar;
+    dev->graphics_type_tag = src->graphics_type_tag;
+    /* There is no finalization for device on stack so no rc increment */
+    (*dev_proc(dev, open_device)) ((gx_device *)dev);
+}
+
+/*
+ * Make a clipping device on the stack that clips to a rectangle given in
+ * whole pixels, without needing a clipping path.
+ */
+void
+gx_make_clip_device_rect_on_stack(gx_device_clip * dev, const gs_int_rect *rect, gx_device *target)
+{
+    gx_device_init_on_stack((gx_device *)dev, (const gx_device *)&gs_clip_device, target->memory);
+    gx_clip_list_init(&dev->list);
+    dev->list.single.xmin = dev->list.xmin = rect->p.x;
+    dev->list.single.xmax = dev->list.xmax = rect->q.x;
+    dev->list.single.ymin = rect->p.y;
+    dev->list.single.ymax = rect->q.y;
+    dev->list.count = 1;
+    dev->translation.x = 0;
+    dev->translation.y = 0;
+    dev->HWResolution[0] = target->HWResolution[0];
+    dev->HWResolution[1] = target->HWResolution[1];
+    dev->sgr = target->sgr;
+    dev->target = target;
+    dev->pad = target->pad;
+    dev->log2_align_mod = target->log2_align_mod;
+    dev->is_planar = target->is_planar;
+    dev->graphics_type_tag = target->graphics_type_tag;	/* initialize to same as target */
+    /* There is no finalization for device on stack so no rc increment */
+    (*dev_proc(dev, open_device)) ((gx_device *)dev);
+}
+
+bool
+gx_device_is_clip(const gx_device *dev)
+{
+    return dev_proc(dev, fill_rectangle) == clip_fill_rectangle;
+}
+
 void
 gx_make_clip_device_in_heap(gx_device_clip *dev,
                       const gx_clip_path   *pcpath,
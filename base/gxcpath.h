@@ -113,6 +113,9 @@ void gx_destroy_clip_device_on_stack(gx_device_clip * dev);
 gx_device *gx_make_clip_device_on_stack_if_needed(gx_device_clip * dev, const gx_clip_path *pcpath, gx_device *target, gs_fixed_rect *rect);
 void gx_make_clip_device_in_heap(gx_device_clip * dev, const gx_clip_path *pcpath, gx_device *target,
                               gs_memory_t *mem);
+void gx_make_clip_device_copy_on_stack(gx_device_clip * dev, const gx_device_clip *src);
+void gx_make_clip_device_rect_on_stack(gx_device_clip * dev, const gs_int_rect *rect, gx_device *target);
+bool gx_device_is_clip(const gx_device *dev);
 
 #define clip_rect_print(ch, str, ar)\
   if_debug7(ch, "[%c]%s "PRI_INTPTR": (%d,%d),(%d,%d)\n", ch, str, (intptr_t)ar,\
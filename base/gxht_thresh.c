@@ -176,6 +176,45 @@ threshold_16_SSE_unaligned(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
     ht_data[0] = bitreverse[sse_data[0]];
     ht_data[1] = bitreverse[sse_data[1]];
 }
+
+#ifdef HAVE_AVX2_TARGET
+#include <immintrin.h>
+
+/* Threshold num_tiles 16 pixel tiles (which must be even) 32 pixels at a
+   time.  Only 128 bit alignment is guaranteed for the inputs, so use
+   unaligned loads.  The caller must check that the CPU supports AVX2. */
+__attribute__((target("avx2")))
+static void
+threshold_32x_AVX2(byte *contone_ptr, byte *thresh_ptr, byte *ht_data,
+                   int num_tiles)
+{
+    const __m256i sign_fix = _mm256_set1_epi8((char)0x80);
+    __m256i input1;
+    __m256i input2;
+    unsigned int result_int;
+
+    for (; num_tiles > 0; num_tiles -= 2) {
+        input1 = _mm256_loadu_si256((const __m256i *)contone_ptr);
+        input2 = _mm256_loadu_si256((const __m256i *)thresh_ptr);
+        input1 = _mm256_xor_si256(input1, sign_fix);
+        input2 = _mm256_xor_si256(input2, sign_fix);
+        input2 = _mm256_subs_epi8(input1, input2);
+        result_int = (unsigned int)_mm256_movemask_epi8(input2);
+        ht_data[0] = bitreverse[result_int & 0xff];
+        ht_data[1] = bitreverse[(result_int >> 8) & 0xff];
+        ht_data[2] = bitreverse[(result_int >> 16) & 0xff];
+        ht_data[3] = bitreverse[result_int >> 24];
+        contone_ptr += 32;
+        thresh_ptr += 32;
+        ht_data += 4;
+    }
+}
+
+#define threshold_have_AVX2() __builtin_cpu_supports("avx2")
+#else
+#define threshold_have_AVX2() 0
+#define threshold_32x_AVX2(c, t, h, n) DO_NOTHING
+#endif
 #endif
 
 /* SSE2 and non-SSE2 implememntation of thresholding a row. Subtractive case
@@ -252,6 +291,8 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
     byte *thresh_ptr;
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
+    /* Pairs of tiles go through the AVX2 code if the CPU has it. */
+    int wide_tiles = threshold_have_AVX2() ? num_tiles & ~1 : 0;
     int k, j;
 
     for (j = 0; j < num_rows; j++) {
@@ -276,7 +317,14 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
         /* Now we should have 128 bit aligned with our input data. Iterate
            over sets of 16 going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
+        if (wide_tiles > 0) {
+            threshold_32x_AVX2(thresh_ptr, contone_ptr, halftone_ptr,
+                               wide_tiles);
+            thresh_ptr += wide_tiles << 4;
+            contone_ptr += wide_tiles << 4;
+            halftone_ptr += wide_tiles << 1;
+        }
+        for (k = wide_tiles; k < num_tiles; k++) {
             threshold_16_SSE(thresh_ptr, contone_ptr, halftone_ptr);
             thresh_ptr += 16;
             contone_ptr += 16;
@@ -357,6 +405,8 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
     byte *thresh_ptr;
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
+    /* Pairs of tiles go through the AVX2 code if the CPU has it. */
+    int wide_tiles = threshold_have_AVX2() ? num_tiles & ~1 : 0;
     int k, j;
 
     for (j = 0; j < num_rows; j++) {
@@ -381,7 +431,14 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
         /* Now we should have 128 bit aligned with our input data. Iterate
            over sets of 16 going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
+        if (wide_tiles > 0) {
+            threshold_32x_AVX2(contone_ptr, thresh_ptr, halftone_ptr,
+                               wide_tiles);
+            thresh_ptr += wide_tiles << 4;
+            contone_ptr += wide_tiles << 4;
+            halftone_ptr += wide_tiles << 1;
+        }
+        for (k = wide_tiles; k < num_tiles; k++) {
             threshold_16_SSE(contone_ptr, thresh_ptr, halftone_ptr);
             thresh_ptr += 16;
             contone_ptr += 16;
@@ -43,6 +43,8 @@
 #include "gzht.h"
 #include "gxht_thresh.h"
 #include "gxdevsop.h"
+#include "gxtpool.h"
+#include "gsicc_manage.h"
 
 typedef union {
     byte v[GS_IMAGE_MAX_COLOR_COMPONENTS];
@@ -52,6 +54,9 @@ typedef union {
     bits32 all[BITS32_PER_COLOR_SAMPLES];	/* for fast comparison */
 } color_samples;
 
+/* Rows narrower than this many pixels per thread are converted serially. */
+#define IMAGE_CM_MIN_STRIP_WIDTH 1024
+
 /* ------ Strategy procedure ------ */
 
 /* Check the prototype. */
@@ -162,6 +167,8 @@ fail:
 #endif
 
 static int image_skip_color_icc_tpr(gx_image_enum *penum, gx_device *dev);
+static void image_cm_threads_init(gx_image_enum *penum, int des_num_comp,
+                                  bool planar_out);
 
 int
 gs_image_class_4_color(gx_image_enum * penum, irender_proc_t *render_fn)
@@ -256,6 +263,13 @@ gs_image_class_4_color(gx_image_enum * penum, irender_proc_t *render_fn)
         penum->icc_link = gsicc_get_link(penum->pgs, penum->dev, pcs, NULL,
             &rendering_params, penum->memory);
     }
+    /* Rows that need no decode can be looked up in the link's cache of
+       converted rows, so repeated placements of an image skip the CMS. */
+    penum->icc_setup.cache_rows = penum->icc_link != NULL &&
+        !penum->icc_setup.need_decode && !penum->icc_link->is_identity &&
+        !penum->icc_link->is_monitored &&
+        penum->icc_link->procs.map_buffer == gscms_transform_color_buffer &&
+        gsicc_currentimagecachesize(penum->memory) > 0;
     /* PS CIE color spaces may have addition decoding that needs to
        be performed to ensure that the range of 0 to 1 is provided
        to the CMM since ICC profiles are restricted to that range
@@ -304,6 +318,7 @@ gs_image_class_4_color(gx_image_enum * penum, irender_proc_t *render_fn)
             if (code == 0) {
                  /* NB: transfer function is pickled into the threshold arrray */
                  penum->icc_setup.has_transfer = false;
+                 image_cm_threads_init(penum, des_num_comp, des_num_comp != 1);
                  *render_fn = &image_render_color_thresh;
                  return code;
             }
@@ -333,6 +348,7 @@ gs_image_class_4_color(gx_image_enum * penum, irender_proc_t *render_fn)
         if (code >= 0) {
             penum->tpr_state = data.state;
             penum->skip_next_line = image_skip_color_icc_tpr;
+            image_cm_threads_init(penum, des_num_comp, false);
             *render_fn = &image_render_color_icc_tpr;
             return code;
         }
@@ -440,6 +456,103 @@ decode_row(const gx_image_enum *penum, const byte *psrc, int spp, byte *pdes,
     }
 }
 
+/* Colour conversion of one row, split into vertical strips so that wide
+   rows can be converted by the worker threads in penum->cm_pool.  Each
+   strip decodes (if needed) and converts its own range of pixels; nothing
+   is allocated and no shared state is written. */
+typedef struct image_cm_strips_s {
+    const gx_image_enum *penum;
+    gx_device *dev;
+    const byte *psrc;
+    byte *psrc_decode;      /* decode scratch for the whole row, or NULL */
+    byte *pdes;
+    int width;              /* pixels in the row */
+    int span;               /* plane stride if planar_out */
+    int spp_cm;
+    bool planar_out;
+} image_cm_strips_t;
+
+static int
+image_cm_strip(void *arg, int strip, int num_strips)
+{
+    const image_cm_strips_t *strips = (const image_cm_strips_t *)arg;
+    const gx_image_enum *penum = strips->penum;
+    int spp = penum->spp;
+    int x0 = (int)((int64_t)strips->width * strip / num_strips);
+    int x1 = (int)((int64_t)strips->width * (strip + 1) / num_strips);
+    int n = x1 - x0;
+    const byte *psrc = strips->psrc + x0 * spp;
+    byte *pdes;
+    gsicc_bufferdesc_t input_buff_desc;
+    gsicc_bufferdesc_t output_buff_desc;
+
+    if (n <= 0)
+        return 0;
+    if (strips->psrc_decode != NULL) {
+        byte *pdecode = strips->psrc_decode + x0 * spp;
+
+        if (!penum->use_cie_range) {
+            decode_row(penum, psrc, spp, pdecode, pdecode + n * spp);
+        } else {
+            /* Decode needs to include adjustment for CIE range */
+            decode_row_cie(penum, psrc, spp, pdecode, pdecode + n * spp,
+                           get_cie_range(penum->pcs));
+        }
+        psrc = pdecode;
+    }
+    gsicc_init_buffer(&input_buff_desc, spp, 1,
+                      false, false, false, 0, n * spp,
+                      1, n);
+    if (!strips->planar_out) {
+        gsicc_init_buffer(&output_buff_desc, strips->spp_cm, 1,
+                          false, false, false, 0, n * strips->spp_cm,
+                          1, n);
+        pdes = strips->pdes + x0 * strips->spp_cm;
+    } else {
+        gsicc_init_buffer(&output_buff_desc, strips->spp_cm, 1,
+                          false, false, true, strips->span, strips->span,
+                          1, n);
+        pdes = strips->pdes + x0;
+    }
+    return (penum->icc_link->procs.map_buffer)(strips->dev, penum->icc_link,
+                                               &input_buff_desc,
+                                               &output_buff_desc,
+                                               (void *)psrc, (void *)pdes);
+}
+
+/* If requested with -dImageColorThreads, start worker threads to share the
+   colour conversion of wide images.  Only done for links that go through
+   the CMS (whose transforms may be used concurrently); the link variant for
+   the buffer layout is created here, on the interpreter thread, by
+   converting a single pixel before any worker can ask for it. */
+static void
+image_cm_threads_init(gx_image_enum *penum, int des_num_comp, bool planar_out)
+{
+    int num_strips = gsicc_currentimagethreads(penum->memory);
+    gsicc_bufferdesc_t input_buff_desc;
+    gsicc_bufferdesc_t output_buff_desc;
+    byte src[GS_IMAGE_MAX_COLOR_COMPONENTS];
+    byte des[GS_CLIENT_COLOR_MAX_COMPONENTS];
+
+    if (num_strips < 2 || penum->icc_link == NULL ||
+        penum->icc_link->is_identity ||
+        penum->icc_link->procs.map_buffer != gscms_transform_color_buffer ||
+        penum->rect.w < num_strips * IMAGE_CM_MIN_STRIP_WIDTH ||
+        des_num_comp > GS_CLIENT_COLOR_MAX_COMPONENTS)
+        return;
+    memset(src, 0, sizeof(src));
+    gsicc_init_buffer(&input_buff_desc, penum->spp, 1,
+                      false, false, false, 0, penum->spp, 1, 1);
+    gsicc_init_buffer(&output_buff_desc, des_num_comp, 1,
+                      false, false, planar_out, 1, des_num_comp, 1, 1);
+    if ((penum->icc_link->procs.map_buffer)(penum->dev, penum->icc_link,
+                                            &input_buff_desc, &output_buff_desc,
+                                            src, des) < 0)
+        return;
+    /* Failure (e.g. no thread support) just means we convert serially. */
+    (void)gx_tpool_alloc(penum->memory, num_strips, &penum->cm_pool);
+}
+
 /* Common code shared amongst the thresholding and non thresholding color image
    renderers */
 static int
@@ -450,8 +563,6 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
     const gx_image_enum *const penum = penum_orig; /* const within proc */
     const gs_gstate *pgs = penum->pgs;
     bool need_decode = penum->icc_setup.need_decode;
-    gsicc_bufferdesc_t input_buff_desc;
-    gsicc_bufferdesc_t output_buff_desc;
     int spp_cm;
     int spp = penum->spp;
     bool force_planar = false;
@@ -537,53 +648,66 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
                 }
             }
         } else {
-            /* Set up the buffer descriptors. planar out always ends up here */
-            gsicc_init_buffer(&input_buff_desc, spp, 1,
-                          false, false, false, 0, w,
-                          1, width);
-            if (!force_planar) {
-                gsicc_init_buffer(&output_buff_desc, spp_cm, 1,
-                              false, false, false, 0, width * spp_cm,
-                              1, width);
-            } else {
-                gsicc_init_buffer(&output_buff_desc, spp_cm, 1,
-                              false, false, true, span, span,
-                              1, width);
-            }
-            /* For now, just blast it all through the link. If we had a significant reduction
-               we will want to repack the data first and then do this.  That will be
+            /* Planar out always ends up here.  For now, just blast it all
+               through the link. If we had a significant reduction we will
+               want to repack the data first and then do this.  That will be
                an optimization shortly.  For now just allocate a new output
-               buffer.  We can reuse the old one if the number of channels in the output is
-               less than or equal to the new one.  */
+               buffer.  We can reuse the old one if the number of channels in
+               the output is less than or equal to the new one.  */
+            image_cm_strips_t strips;
+            uint des_size = (force_planar ? span : width) * spp_cm;
+            uint64_t row_hash = 0;
+            int x0 = 0, x1 = width;
+
+            /* Only the columns that can reach the clip (drect, set up
+               in gx_image_enum_begin) need converting.  The others are
+               zeroed: the renderer clips them away, but still looks at
+               them to find runs. */
+            if (!force_planar && w == penum->rect.w * spp &&
+                penum->drect.w > 0 && penum->drect.w < penum->rect.w) {
+                x0 = max(penum->drect.x - penum->rect.x, 0);
+                x1 = min(x0 + penum->drect.w, width);
+                if (x0 > 0 || x1 < width) {
+                    memset(*psrc_cm, 0, x0 * spp_cm);
+                    memset(*psrc_cm + x1 * spp_cm, 0, (width - x1) * spp_cm);
+                }
+            }
+            if (penum->icc_setup.cache_rows && x1 - x0 == width) {
+                row_hash = gsicc_row_hash(psrc, w, force_planar);
+                if (gsicc_row_cache_lookup(penum->icc_link, row_hash, force_planar,
+                                           psrc, w, *psrc_cm, des_size)) {
+                    *spp_cm_out = spp_cm;
+                    return 0;
+                }
+            }
+            strips.penum = penum;
+            strips.dev = dev;
+            strips.psrc = psrc + x0 * spp;
+            strips.psrc_decode = NULL;
+            strips.pdes = *psrc_cm + x0 * spp_cm;
+            strips.width = x1 - x0;
+            strips.span = span;
+            strips.spp_cm = spp_cm;
+            strips.planar_out = force_planar;
             if (need_decode) {
                 /* Need decode and CM.  This is slow but does not happen that often */
-                psrc_decode = gs_alloc_bytes(pgs->memory, w,
-                                              "image_color_icc_prep");
-                if (!penum->use_cie_range) {
-                    decode_row(penum, psrc, spp, psrc_decode, psrc_decode+w);
-                } else {
-                    /* Decode needs to include adjustment for CIE range */
-                    decode_row_cie(penum, psrc, spp, psrc_decode,
-                                    psrc_decode+w, get_cie_range(penum->pcs));
-                }
-                code = (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                    &input_buff_desc,
-                                                    &output_buff_desc,
-                                                    (void*) psrc_decode,
-                                                    (void*) *psrc_cm);
-                gs_free_object(pgs->memory, psrc_decode, "image_color_icc_prep");
-                if (code < 0)
-                    return code;
-            } else {
-                /* CM only. No decode */
-                code = (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                    &input_buff_desc,
-                                                    &output_buff_desc,
-                                                    (void*) psrc,
-                                                    (void*) *psrc_cm);
-                if (code < 0)
-                    return code;
+                strips.psrc_decode = gs_alloc_bytes(pgs->memory, w,
+                                                    "image_color_icc_prep");
+                if (strips.psrc_decode == NULL)
+                    return_error(gs_error_VMerror);
             }
+            if (penum->cm_pool != NULL &&
+                strips.width >= gx_tpool_num_strips(penum->cm_pool) * IMAGE_CM_MIN_STRIP_WIDTH)
+                code = gx_tpool_run(penum->cm_pool, image_cm_strip, &strips);
+            else
+                code = image_cm_strip(&strips, 0, 1);
+            if (strips.psrc_decode != NULL)
+                gs_free_object(pgs->memory, strips.psrc_decode, "image_color_icc_prep");
+            if (code < 0)
+                return code;
+            if (penum->icc_setup.cache_rows && x1 - x0 == width)
+                gsicc_row_cache_add(penum->icc_link, row_hash, force_planar,
+                                    psrc, w, *psrc_cm, des_size);
         }
     }
     *spp_cm_out = spp_cm;
@@ -22,6 +22,7 @@
 #include "gxcpath.h"
 #include "gximage.h"
 #include "gsicc_cache.h"
+#include "gxtpool.h"
 #ifdef WITH_CAL
 #include "cal.h"
 #endif
@@ -505,6 +506,10 @@ gx_image1_end_image(gx_image_enum_common_t * info, bool draw_last)
     if (penum->icc_link != NULL) {
         gsicc_release_link(penum->icc_link);
     }
+    if (penum->cm_pool != NULL) {
+        gx_tpool_free(penum->cm_pool);
+        penum->cm_pool = NULL;
+    }
     if (penum->color_cache != NULL) {
         gs_free_object(mem, penum->color_cache->device_contone,
                         "device_contone");
@@ -160,6 +160,7 @@ typedef struct gx_image_icc_setup_s {
     bool is_lab; /* used in icc processing */
     bool must_halftone; /* used in icc processing */
     bool has_transfer; /* used in icc processing */
+    bool cache_rows; /* converted rows are kept in the link's row cache */
 } gx_image_icc_setup_t;
 
 struct gx_image_enum_s {
@@ -290,6 +291,8 @@ struct gx_image_enum_s {
     byte *thresh_buffer;    /* A buffer to hold threshold values for HT */
     int thresh_stride;
     gs_image_parent_t image_parent_type;   /* Need to avoid threshold of type3 images */
+    struct gx_tpool_s *cm_pool; /* Worker threads for colour conversion of */
+                                /* wide rows (non-GC, may be NULL) */
     ht_landscape_info_t ht_landscape;
     gx_image_icc_setup_t icc_setup;
     bool use_cie_range;   /* Needed potentially if CS was PS CIE based */
@@ -292,6 +292,7 @@ gx_image_enum_begin(gx_device * dev, const gs_gstate * pgs,
     penum->icc_setup.is_lab = false;
     penum->icc_setup.must_halftone = false;
     penum->icc_setup.need_decode = false;
+    penum->icc_setup.cache_rows = false;
     penum->Width = width;
     penum->Height = height;
 
@@ -816,6 +817,7 @@ gx_image_enum_begin(gx_device * dev, const gs_gstate * pgs,
     penum->line = NULL;
     penum->icc_link = NULL;
     penum->color_cache = NULL;
+    penum->cm_pool = NULL;
     penum->ht_buffer = NULL;
     penum->thresh_buffer = NULL;
     penum->use_cie_range = false;
@@ -423,6 +423,9 @@ gs_shading_A_fill_rectangle_aux(const gs_shading_t * psh0, const gs_rect * rect,
     pfs1.Function = pfn;
     pfs1.rect = *clip_rect;
     code = init_patch_fill_state(&pfs1);
+    if (code < 0)
+        goto fail;
+    code = patch_function_lut_init(&pfs1, d0, d1);
     if (code < 0)
         goto fail;
     pfs1.maybe_self_intersecting = false;
@@ -2389,6 +2392,12 @@ gs_shading_R_fill_rectangle_aux(const gs_shading_t * psh0, const gs_rect * rect,
     pfs1.function_arg_shift = 0;
     pfs1.rect = *clip_rect;
     pfs1.maybe_self_intersecting = false;
+    code = patch_function_lut_init(&pfs1, d0, d1);
+    if (code < 0) {
+        if (pfs1.icclink != NULL) gsicc_release_link(pfs1.icclink);
+        term_patch_fill_state(&pfs1);
+        return code;
+    }
     if (is_radial_shading_large(x0, y0, r0, x1, y1, r1, rect))
         span_type = compute_radial_shading_span(&rsa, x0, y0, r0, x1, y1, r1, rect);
     else
@@ -113,6 +113,8 @@ struct patch_color_s {
        and from patch_fill_state_s::num_components. */
 };
 
+typedef struct patch_function_lut_s patch_function_lut_t;
+
 /* Define the common state for rendering Coons and tensor patches. */
 struct patch_fill_state_s {
     mesh_fill_state_common;
@@ -141,6 +143,8 @@ struct patch_fill_state_s {
     byte *color_stack_limit;
     gs_memory_t *memory; /* Where color_buffer is allocated. */
     gs_color_index_cache_t *pcic;
+    struct gx_monitor_s *cm_lock; /* Serializes color mapping between band threads, or NULL. */
+    patch_function_lut_t *function_lut; /* Samples of a 1-input Function, or NULL. */
 } ;
 
 /* Define a structure for mesh or patch vertex. */
@@ -169,6 +173,7 @@ int mesh_init_fill_state(mesh_fill_state_t * pfs,
 
 int init_patch_fill_state(patch_fill_state_t *pfs);
 bool term_patch_fill_state(patch_fill_state_t *pfs);
+int patch_function_lut_init(patch_fill_state_t *pfs, float t0, float t1);
 int gx_init_patch_fill_state_for_clist(gx_device *dev, patch_fill_state_t *pfs, gs_memory_t *memory);
 
 int mesh_triangle(patch_fill_state_t *pfs,
@@ -37,6 +37,13 @@
 #include "math_.h"
 #include "gsicc_cache.h"
 #include "gxdevsop.h"
+#include "gxcpath.h"
+#include "gxdevmem.h"
+#include "gxsync.h"
+#include "gxtpool.h"
+#include "gslibctx.h"
+#include "gsfunc3.h"
+#include "gsfunc4.h"
 
 /* The original version of the shading code 'decompose's shadings into
  * smaller and smaller regions until they are smaller than 1 pixel, and then
@@ -137,6 +144,22 @@ release_colors(patch_fill_state_t *pfs, byte *ptr, int n)
     release_colors_inline(pfs, ptr, n);
 }
 
+/* Color mapping goes through the gstate and the ICC link cache, which are
+   not thread safe, so band threads (see patch_fill_bands) take turns. */
+static inline void
+patch_cm_enter(const patch_fill_state_t *pfs)
+{
+    if (pfs->cm_lock != NULL)
+        gx_monitor_enter(pfs->cm_lock);
+}
+
+static inline void
+patch_cm_leave(const patch_fill_state_t *pfs)
+{
+    if (pfs->cm_lock != NULL)
+        gx_monitor_leave(pfs->cm_lock);
+}
+
 /* Get colors for patch vertices. */
 static int
 shade_next_colors(shade_coord_stream_t * cs, patch_curve_t * curves,
@@ -253,6 +276,174 @@ alloc_patch_fill_memory(patch_fill_state_t *pfs, gs_memory_t *memory, const gs_c
     return 0;
 }
 
+/* ---------------- Sampled shading functions ---------------- */
+
+/*
+ * Axial and radial shadings evaluate their Function at every point of the
+ * decomposition, which dominates the time spent on them when it is a
+ * PostScript calculator or a stitching function.  Instead, the Domain is
+ * divided into PATCH_FUNCTION_LUT_SIZE intervals, and the function values
+ * inside an interval are interpolated linearly between its ends when the
+ * value at its middle is within cc_max_error of the interpolated one.
+ * Samples and interval checks are computed when they are first needed;
+ * intervals that fail the check go on evaluating the Function, as do the
+ * intervals containing the Bounds of a stitching function, where the
+ * Function may jump without the middle value showing it.  Interpolation
+ * can still differ from the Function by a level or so, and a PostScript
+ * calculator can have steps narrower than an interval that the check does
+ * not see, so the table is only used when ShadingFunctionTable is set.
+ */
+
+#define PATCH_FUNCTION_LUT_SIZE 256
+
+enum {
+    lut_unknown = 0,
+    lut_linear,
+    lut_exact
+};
+
+struct patch_function_lut_s {
+    float t0, t1;
+    double scale;       /* intervals per unit of t */
+    float *samples;     /* (PATCH_FUNCTION_LUT_SIZE + 1) * num_components */
+    byte have_sample[PATCH_FUNCTION_LUT_SIZE + 1];
+    byte interval[PATCH_FUNCTION_LUT_SIZE];
+};
+
+/* Make the intervals containing the stitching Bounds of pfn exact.  t = a + b * x */
+/* maps the input x of pfn to the input of the shading Function. */
+static void
+patch_function_lut_mark_bounds(patch_function_lut_t *lut, const gs_function_t *pfn,
+                               double a, double b, int depth)
+{
+    int i;
+
+    if (depth > 8)
+        return;
+    if (pfn->head.type == function_type_1InputStitching) {
+        const gs_function_1ItSg_params_t *params = (const gs_function_1ItSg_params_t *)&pfn->params;
+
+        for (i = 0; i < params->k; i++) {
+            double lo = (i == 0 ? params->Domain[0] : params->Bounds[i - 1]);
+            double hi = (i == params->k - 1 ? params->Domain[1] : params->Bounds[i]);
+            double e0 = params->Encode[2 * i], e1 = params->Encode[2 * i + 1];
+
+            if (i > 0) {
+                double x = ((a + b * lo) - lut->t0) * lut->scale;
+
+                if (x >= 0 && x <= PATCH_FUNCTION_LUT_SIZE) {
+                    int j = (int)x;
+
+                    /* A boundary on the end of an interval affects both neighbours. */
+                    if (j < PATCH_FUNCTION_LUT_SIZE)
+                        lut->interval[j] = lut_exact;
+                    if (j > 0 && x == j)
+                        lut->interval[j - 1] = lut_exact;
+                }
+            }
+            if (e1 != e0 && hi > lo)
+                patch_function_lut_mark_bounds(lut, params->Functions[i],
+                                               a + b * (lo - e0 * (hi - lo) / (e1 - e0)),
+                                               b * (hi - lo) / (e1 - e0), depth + 1);
+        }
+    } else if (pfn->head.type == function_type_ArrayedOutput) {
+        gs_function_info_t info;
+
+        gs_function_get_info(pfn, &info);
+        for (i = 0; i < info.num_Functions; i++)
+            patch_function_lut_mark_bounds(lut, info.Functions[i], a, b, depth + 1);
+    }
+}
+
+/* Set up sampling of pfs->Function (with 1 input) over [t0, t1]. */
+int
+patch_function_lut_init(patch_fill_state_t *pfs, float t0, float t1)
+{
+    patch_function_lut_t *lut;
+
+    if (t0 > t1) {
+        float t = t0;
+
+        t0 = t1;
+        t1 = t;
+    }
+    /* An exponential function costs no more than a table lookup. */
+    if (pfs->Function == NULL || !(t1 > t0) ||
+        pfs->Function->head.type == function_type_ExponentialInterpolation ||
+        !gs_lib_ctx_get_shading_function_table(pfs->memory))
+        return 0;
+    lut = (patch_function_lut_t *)gs_alloc_bytes(pfs->memory,
+                        sizeof(patch_function_lut_t), "patch_function_lut_init");
+    if (lut == NULL)
+        return_error(gs_error_VMerror);
+    memset(lut, 0, sizeof(*lut));
+    lut->samples = (float *)gs_alloc_byte_array(pfs->memory,
+                        (PATCH_FUNCTION_LUT_SIZE + 1) * pfs->num_components,
+                        sizeof(float), "patch_function_lut_init");
+    if (lut->samples == NULL) {
+        gs_free_object(pfs->memory, lut, "patch_function_lut_init");
+        return_error(gs_error_VMerror);
+    }
+    lut->t0 = t0;
+    lut->t1 = t1;
+    lut->scale = PATCH_FUNCTION_LUT_SIZE / ((double)t1 - t0);
+    patch_function_lut_mark_bounds(lut, pfs->Function, 0, 1, 0);
+    pfs->function_lut = lut;
+    return 0;
+}
+
+static inline const float *
+patch_function_lut_sample(const patch_fill_state_t *pfs, int i)
+{
+    patch_function_lut_t *lut = pfs->function_lut;
+    float *v = lut->samples + i * pfs->num_components;
+
+    if (!lut->have_sample[i]) {
+        float t = (i == PATCH_FUNCTION_LUT_SIZE ? lut->t1 : lut->t0 + i / lut->scale);
+
+        gs_function_evaluate(pfs->Function, &t, v);
+        lut->have_sample[i] = 1;
+    }
+    return v;
+}
+
+/* Interpolate the Function value at t from the samples. */
+/* Return false if it must be evaluated. */
+static inline bool
+patch_function_lut_lookup(const patch_fill_state_t *pfs, float t, float *v)
+{
+    patch_function_lut_t *lut = pfs->function_lut;
+    double x = (t - lut->t0) * lut->scale;
+    const float *v0, *v1;
+    int i, ci;
+
+    if (!(x >= 0 && x <= PATCH_FUNCTION_LUT_SIZE))
+        return false;
+    i = (int)x;
+    if (i == PATCH_FUNCTION_LUT_SIZE)
+        i--;
+    if (lut->interval[i] == lut_exact)
+        return false;
+    v0 = patch_function_lut_sample(pfs, i);
+    v1 = patch_function_lut_sample(pfs, i + 1);
+    if (lut->interval[i] == lut_unknown) {
+        float tm = lut->t0 + (i + 0.5) / lut->scale;
+        float vm[GS_CLIENT_COLOR_MAX_COMPONENTS];
+
+        gs_function_evaluate(pfs->Function, &tm, vm);
+        lut->interval[i] = lut_linear;
+        for (ci = 0; ci < pfs->num_components; ci++)
+            if (any_abs((v0[ci] + v1[ci]) / 2 - vm[ci]) > pfs->cc_max_error[ci]) {
+                lut->interval[i] = lut_exact;
+                return false;
+            }
+    }
+    x -= i;
+    for (ci = 0; ci < pfs->num_components; ci++)
+        v[ci] = (float)(v0[ci] + (v1[ci] - v0[ci]) * x);
+    return true;
+}
+
 int
 init_patch_fill_state(patch_fill_state_t *pfs)
 {
@@ -294,6 +485,8 @@ init_patch_fill_state(patch_fill_state_t *pfs)
     pfs->color_stack_ptr = NULL;
     pfs->color_stack = NULL;
     pfs->color_stack_limit = NULL;
+    pfs->cm_lock = NULL;
+    pfs->function_lut = NULL;
     pfs->unlinear = !is_linear_color_applicable(pfs);
     return alloc_patch_fill_memory(pfs, pfs->pgs->memory, pcs);
 }
@@ -309,6 +502,11 @@ term_patch_fill_state(patch_fill_state_t *pfs)
         gs_free_object(pfs->memory, pfs->color_stack, "term_patch_fill_state");
     if (pfs->pcic != NULL)
         gs_color_index_cache_destroy(pfs->pcic);
+    if (pfs->function_lut != NULL) {
+        gs_free_object(pfs->memory, pfs->function_lut->samples, "term_patch_fill_state");
+        gs_free_object(pfs->memory, pfs->function_lut, "term_patch_fill_state");
+        pfs->function_lut = NULL;
+    }
     return b;
 }
 
@@ -319,7 +517,9 @@ patch_resolve_color_inline(patch_color_t * ppcr, const patch_fill_state_t *pfs)
     if (pfs->Function) {
         const gs_color_space *pcs = pfs->direct_space;
 
-        gs_function_evaluate(pfs->Function, ppcr->t, ppcr->cc.paint.values);
+        if (pfs->function_lut == NULL ||
+            !patch_function_lut_lookup(pfs, ppcr->t[0], ppcr->cc.paint.values))
+            gs_function_evaluate(pfs->Function, ppcr->t, ppcr->cc.paint.values);
         pcs->type->restrict_color(&ppcr->cc, pcs);
     }
 }
@@ -401,6 +601,274 @@ curve_eval(gs_fixed_point * pt, const gs_fixed_point * p0,
               fixed2float(pt->y));
 }
 
+/* ---------------- Filling patches on several threads ---------------- */
+
+/*
+ * When ShadingThreads is set, Coons and tensor product patch shadings are
+ * filled in horizontal bands, one per thread.  Each band has its own copy
+ * of the fill state (with its own color stack and wedge buffer) whose
+ * fill rectangle is restricted to the band, and draws through a clipping
+ * device that keeps it to the rows of the band, since the decomposition
+ * may spill a little over pfs->rect.  If the target is already reached
+ * through a clipping device, each band also gets its own copy of that one
+ * (its enumeration cursor is not shareable).  Every band paints all the
+ * patches of a batch in stream order, so overlapping patches come out
+ * exactly as they do when filled serially, whatever the number of
+ * threads.  Patches are read from the data stream in batches on the
+ * calling thread.
+ */
+
+#define PATCH_BATCH_SIZE 256
+#define PATCH_MIN_BAND_HEIGHT int2fixed(32)
+
+typedef struct patch_batch_elem_s {
+    patch_curve_t curve[4];
+    gs_fixed_point interior[4];
+} patch_batch_elem_t;
+
+typedef struct patch_bands_s {
+    patch_fill_state_t *band;
+    gx_device_clip *rows;       /* clips each band to its rows */
+    gx_device_clip *copy;       /* copies of pfs->dev if it is a clipper */
+    gx_device *dev;             /* pfs->dev */
+    int num_bands;
+    patch_batch_elem_t *batch;
+    int count;
+    bool tensor;
+    void (*transform) (gs_fixed_point *, const patch_curve_t[4],
+                       const gs_fixed_point[4], double, double);
+} patch_bands_t;
+
+/* Check whether a shading function can be evaluated on several threads */
+/* at once.  Sampled functions cache decoded samples, so they can't. */
+static bool
+patch_function_is_reentrant(const gs_function_t *pfn)
+{
+    switch (pfn->head.type) {
+        case function_type_ExponentialInterpolation:
+        case function_type_PostScript_Calculator:
+            return true;
+        case function_type_1InputStitching:
+        case function_type_ArrayedOutput: {
+            gs_function_info_t info;
+            int i;
+
+            gs_function_get_info(pfn, &info);
+            for (i = 0; i < info.num_Functions; i++)
+                if (!patch_function_is_reentrant(info.Functions[i]))
+                    return false;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/* Return the number of bands to fill the patches in, */
+/* or 0 if they must be filled on the calling thread. */
+static int
+patch_fill_num_bands(const patch_fill_state_t *pfs)
+{
+    int num_bands = gs_lib_ctx_get_shading_threads(pfs->memory);
+    fixed height = pfs->rect.q.y - pfs->rect.p.y;
+    gx_device *dev = pfs->dev;
+
+    if (num_bands < 2)
+        return 0;
+    if (height / num_bands < PATCH_MIN_BAND_HEIGHT)
+        num_bands = height / PATCH_MIN_BAND_HEIGHT;
+    if (num_bands < 2)
+        return 0;
+    /* Only memory devices, possibly behind a clipping device, can be */
+    /* painted from several threads as long as they touch separate rows. */
+    if (gx_device_is_clip(dev))
+        dev = ((gx_device_clip *)dev)->target;
+    if (!gs_device_is_memory(dev) || gs_device_is_abuf(dev))
+        return 0;
+    if (pfs->Function != NULL && !patch_function_is_reentrant(pfs->Function))
+        return 0;
+    /* Halftoned colours render their tiles into the halftone order's */
+    /* cache as they are loaded, which the bands would race on. */
+    if (gx_get_cmap_procs(pfs->pgs, pfs->dev)->is_halftoned(pfs->pgs, pfs->dev))
+        return 0;
+    return num_bands;
+}
+
+/* Fill the current batch of patches in one band. */
+static int
+patch_fill_band(void *arg, int band, int num_bands)
+{
+    patch_bands_t *pb = (patch_bands_t *)arg;
+    patch_fill_state_t *pfs = &pb->band[band];
+    int i, code = 0;
+
+    if (pfs->rect.q.y <= pfs->rect.p.y)
+        return 0;
+    for (i = 0; i < pb->count && code >= 0; i++)
+        code = patch_fill(pfs, pb->batch[i].curve,
+                          (pb->tensor ? pb->batch[i].interior : NULL),
+                          pb->transform);
+    return code;
+}
+
+/* Update the vertical extent of a batch with the points of a patch. */
+static void
+patch_extent_y(const patch_batch_elem_t *e, bool tensor, fixed *y0, fixed *y1)
+{
+    int i;
+
+#define EXTEND_Y(y)\
+    BEGIN if ((y) < *y0) *y0 = (y); if ((y) > *y1) *y1 = (y); END
+    for (i = 0; i < 4; i++) {
+        EXTEND_Y(e->curve[i].vertex.p.y);
+        EXTEND_Y(e->curve[i].control[0].y);
+        EXTEND_Y(e->curve[i].control[1].y);
+        if (tensor)
+            EXTEND_Y(e->interior[i].y);
+    }
+#undef EXTEND_Y
+}
+
+/*
+ * Divide rect between the bands, spreading the part of it covered by the
+ * batch ([y0, y1]) evenly.  Band boundaries are on pixel boundaries so that
+ * no row is painted by two threads.
+ */
+static void
+patch_bands_set_rects(patch_bands_t *pb, const gs_fixed_rect *rect,
+                      fixed y0, fixed y1)
+{
+    fixed y = rect->p.y;
+    gs_int_rect rows;
+    int k;
+
+    y0 = max(y0, rect->p.y);
+    y1 = min(y1, rect->q.y);
+    if (y1 <= y0)
+        y0 = rect->p.y, y1 = rect->q.y;
+    for (k = 0; k < pb->num_bands; k++) {
+        patch_fill_state_t *pfs = &pb->band[k];
+        fixed ytop = rect->q.y;
+
+        if (k < pb->num_bands - 1) {
+            ytop = fixed_floor(y0 + (fixed)((int64_t)(y1 - y0) * (k + 1) /
+                                            pb->num_bands));
+            if (ytop < y)
+                ytop = y;
+        }
+        pfs->rect = *rect;
+        pfs->rect.p.y = y;
+        pfs->rect.q.y = ytop;
+        rows.p.x = min_int_in_fixed;
+        rows.q.x = max_int_in_fixed;
+        rows.p.y = (k == 0 ? min_int_in_fixed : fixed2int(y));
+        rows.q.y = (k == pb->num_bands - 1 ? max_int_in_fixed : fixed2int(ytop));
+        gx_make_clip_device_rect_on_stack(&pb->rows[k], &rows,
+                        (pb->copy != NULL ? (gx_device *)&pb->copy[k] : pb->dev));
+        pfs->dev = (gx_device *)&pb->rows[k];
+        y = ytop;
+    }
+}
+
+static int
+patch_fill_bands(patch_fill_state_t *pfs, shade_coord_stream_t *cs,
+                 int BitsPerFlag, bool tensor, int num_bands,
+                 void (*transform) (gs_fixed_point *, const patch_curve_t[4],
+                                    const gs_fixed_point[4], double, double))
+{
+    gs_memory_t *mem = pfs->memory->non_gc_memory;
+    gx_tpool_t *pool = NULL;
+    gx_monitor_t *lock = NULL;
+    patch_bands_t pb;
+    patch_curve_t curve[4];
+    gs_fixed_point interior[4];
+    int k, code;
+
+    /* Without threads, fill everything as a single band. */
+    if (gx_tpool_alloc(pfs->memory, num_bands, &pool) < 0)
+        num_bands = 1;
+    memset(&pb, 0, sizeof(pb));
+    pb.dev = pfs->dev;
+    pb.tensor = tensor;
+    pb.transform = transform;
+    pb.band = (patch_fill_state_t *)gs_alloc_byte_array(mem, num_bands,
+                                sizeof(patch_fill_state_t), "patch_fill_bands");
+    pb.batch = (patch_batch_elem_t *)gs_alloc_byte_array(mem, PATCH_BATCH_SIZE,
+                                sizeof(patch_batch_elem_t), "patch_fill_bands");
+    pb.rows = (gx_device_clip *)gs_alloc_byte_array(mem, num_bands,
+                                sizeof(gx_device_clip), "patch_fill_bands");
+    if (gx_device_is_clip(pfs->dev))
+        pb.copy = (gx_device_clip *)gs_alloc_byte_array(mem, num_bands,
+                                sizeof(gx_device_clip), "patch_fill_bands");
+    if (num_bands > 1)
+        lock = gx_monitor_label(gx_monitor_alloc(mem), "patch_fill_bands");
+    if (pb.band == NULL || pb.batch == NULL || pb.rows == NULL ||
+        (pb.copy == NULL && gx_device_is_clip(pfs->dev)) ||
+        (lock == NULL && num_bands > 1)) {
+        code = gs_note_error(gs_error_VMerror);
+        goto out;
+    }
+    code = 0;
+    for (; pb.num_bands < num_bands && code >= 0; pb.num_bands++) {
+        patch_fill_state_t *band = &pb.band[pb.num_bands];
+
+        *band = *pfs;
+        band->color_stack = NULL;
+        band->wedge_vertex_list_elem_buffer = NULL;
+        band->free_wedge_vertex = NULL;
+        band->pcic = NULL;
+        band->function_lut = NULL;
+        band->cm_lock = lock;
+        if (pb.copy != NULL)
+            gx_make_clip_device_copy_on_stack(&pb.copy[pb.num_bands],
+                                              (const gx_device_clip *)pfs->dev);
+        code = alloc_patch_fill_memory(band, pfs->memory, pfs->direct_space);
+    }
+    curve[0].straight = curve[1].straight = curve[2].straight = curve[3].straight = false;
+    while (code == 0) {
+        fixed y0 = max_fixed, y1 = min_fixed;
+
+        pb.count = 0;
+        while (pb.count < PATCH_BATCH_SIZE &&
+               (code = shade_next_patch(cs, BitsPerFlag, curve,
+                                        (tensor ? interior : NULL))) == 0) {
+            patch_batch_elem_t *e = &pb.batch[pb.count++];
+
+            memcpy(e->curve, curve, sizeof(curve));
+            if (tensor) {
+                /* See gs_shading_Tpp_fill_rectangle. */
+                e->interior[0] = interior[0];
+                e->interior[1] = interior[3];
+                e->interior[2] = interior[2];
+                e->interior[3] = interior[1];
+            }
+            patch_extent_y(e, tensor, &y0, &y1);
+        }
+        if (code >= 0 && pb.count > 0) {
+            int code1;
+
+            patch_bands_set_rects(&pb, &pfs->rect, y0, y1);
+            if (pool != NULL)
+                code1 = gx_tpool_run(pool, patch_fill_band, &pb);
+            else
+                code1 = patch_fill_band(&pb, 0, 1);
+            if (code1 < 0)
+                code = code1;
+        }
+    }
+out:
+    for (k = 0; k < pb.num_bands; k++)
+        if (term_patch_fill_state(&pb.band[k]) && code >= 0)
+            code = gs_note_error(gs_error_unregistered); /* Must not happen. */
+    gx_tpool_free(pool);
+    gx_monitor_free(lock);
+    gs_free_object(mem, pb.copy, "patch_fill_bands");
+    gs_free_object(mem, pb.rows, "patch_fill_bands");
+    gs_free_object(mem, pb.batch, "patch_fill_bands");
+    gs_free_object(mem, pb.band, "patch_fill_bands");
+    return code;
+}
+
 /* ---------------- Coons patch shading ---------------- */
 
 /* Calculate the device-space coordinate corresponding to (u,v). */
@@ -446,7 +914,7 @@ gs_shading_Cp_fill_rectangle(const gs_shading_t * psh0, const gs_rect * rect,
     patch_fill_state_t state;
     shade_coord_stream_t cs;
     patch_curve_t curve[4];
-    int code;
+    int num_bands, code;
 
     code = mesh_init_fill_state((mesh_fill_state_t *) &state,
                          (const gs_shading_mesh_t *)psh0, rect_clip, dev, pgs);
@@ -463,11 +931,17 @@ gs_shading_Cp_fill_rectangle(const gs_shading_t * psh0, const gs_rect * rect,
 
     curve[0].straight = curve[1].straight = curve[2].straight = curve[3].straight = false;
     shade_next_init(&cs, (const gs_shading_mesh_params_t *)&psh->params, pgs);
-    while ((code = shade_next_patch(&cs, psh->params.BitsPerFlag,
-                                    curve, NULL)) == 0 &&
-           (code = patch_fill(&state, curve, NULL, Cp_transform)) >= 0
-        ) {
-        DO_NOTHING;
+    num_bands = patch_fill_num_bands(&state);
+    if (num_bands > 0)
+        code = patch_fill_bands(&state, &cs, psh->params.BitsPerFlag, false,
+                                num_bands, Cp_transform);
+    else {
+        while ((code = shade_next_patch(&cs, psh->params.BitsPerFlag,
+                                        curve, NULL)) == 0 &&
+               (code = patch_fill(&state, curve, NULL, Cp_transform)) >= 0
+            ) {
+            DO_NOTHING;
+        }
     }
     if (term_patch_fill_state(&state))
         return_error(gs_error_unregistered); /* Must not happen. */
@@ -536,7 +1010,7 @@ gs_shading_Tpp_fill_rectangle(const gs_shading_t * psh0, const gs_rect * rect,
     shade_coord_stream_t cs;
     patch_curve_t curve[4];
     gs_fixed_point interior[4];
-    int code;
+    int num_bands, code;
 
     code = mesh_init_fill_state((mesh_fill_state_t *) & state,
                          (const gs_shading_mesh_t *)psh0, rect_clip, dev, pgs);
@@ -550,21 +1024,27 @@ gs_shading_Tpp_fill_rectangle(const gs_shading_t * psh0, const gs_rect * rect,
         return code;
     curve[0].straight = curve[1].straight = curve[2].straight = curve[3].straight = false;
     shade_next_init(&cs, (const gs_shading_mesh_params_t *)&psh->params, pgs);
-    while ((code = shade_next_patch(&cs, psh->params.BitsPerFlag,
-                                    curve, interior)) == 0) {
-        /*
-         * The order of points appears to be consistent with that for Coons
-         * patches, which is different from that documented in Red Book 3.
-         */
-        gs_fixed_point swapped_interior[4];
+    num_bands = patch_fill_num_bands(&state);
+    if (num_bands > 0)
+        code = patch_fill_bands(&state, &cs, psh->params.BitsPerFlag, true,
+                                num_bands, Tpp_transform);
+    else {
+        while ((code = shade_next_patch(&cs, psh->params.BitsPerFlag,
+                                        curve, interior)) == 0) {
+            /*
+             * The order of points appears to be consistent with that for Coons
+             * patches, which is different from that documented in Red Book 3.
+             */
+            gs_fixed_point swapped_interior[4];
 
-        swapped_interior[0] = interior[0];
-        swapped_interior[1] = interior[3];
-        swapped_interior[2] = interior[2];
-        swapped_interior[3] = interior[1];
-        code = patch_fill(&state, curve, swapped_interior, Tpp_transform);
-        if (code < 0)
-            break;
+            swapped_interior[0] = interior[0];
+            swapped_interior[1] = interior[3];
+            swapped_interior[2] = interior[2];
+            swapped_interior[3] = interior[1];
+            code = patch_fill(&state, curve, swapped_interior, Tpp_transform);
+            if (code < 0)
+                break;
+        }
     }
     if (term_patch_fill_state(&state))
         return_error(gs_error_unregistered); /* Must not happen. */
@@ -1352,7 +1832,9 @@ patch_color_to_device_color_inline(const patch_fill_state_t *pfs,
     if (DEBUG_COLOR_INDEX_CACHE && pdevc == NULL)
         pdevc = &devc;
     if (pfs->pcic) {
+        patch_cm_enter(pfs);
         code = gs_cached_color_index(pfs->pcic, c->cc.paint.values, pdevc, frac_values);
+        patch_cm_leave(pfs);
         if (code < 0)
             return code;
     }
@@ -1369,8 +1851,10 @@ patch_color_to_device_color_inline(const patch_fill_state_t *pfs,
                 pdevc = &devc;
             memcpy(fcc.paint.values, c->cc.paint.values,
                         sizeof(fcc.paint.values[0]) * pfs->num_components);
+            patch_cm_enter(pfs);
             code = pcs->type->remap_color(&fcc, pcs, pdevc, pfs->pgs,
                                       pfs->trans_device, gs_color_select_texture);
+            patch_cm_leave(pfs);
             if (code < 0)
                 return code;
             if (frac_values != NULL) {
@@ -1542,8 +2026,10 @@ is_color_linear(const patch_fill_state_t *pfs, const patch_color_t *c0, const pa
             return 0;
         if (pfs->cs_always_linear)
             return 1;
+        patch_cm_enter(pfs);
         code = cs_is_linear(cs, pfs->pgs, pfs->trans_device,
                 &c0->cc, &c1->cc, NULL, NULL, pfs->smoothness - s, pfs->icclink);
+        patch_cm_leave(pfs);
         if (code <= 0)
             return code;
         return 1;
@@ -2079,10 +2565,13 @@ try_device_linear_color(patch_fill_state_t *pfs, bool wedge,
             s012 = max(s01, s2);
             if (pfs->cs_always_linear)
                 code = 1;
-            else
+            else {
+                patch_cm_enter(pfs);
                 code = cs_is_linear(cs, pfs->pgs, pfs->trans_device,
                                   &p0->c->cc, &p1->c->cc, &p2->c->cc, NULL,
                                   pfs->smoothness - s012, pfs->icclink);
+                patch_cm_leave(pfs);
+            }
             if (code < 0)
                 return code;
             if (code == 0)
@@ -3034,6 +3523,8 @@ gx_init_patch_fill_state_for_clist(gx_device *dev, patch_fill_state_t *pfs, gs_m
     pfs->color_stack = NULL; /* fixme */
     pfs->color_stack_limit = NULL; /* fixme */
     pfs->pcic = NULL; /* Will do someday. */
+    pfs->cm_lock = NULL;
+    pfs->function_lut = NULL;
     pfs->trans_device = NULL;
     pfs->icclink = NULL;
     return alloc_patch_fill_memory(pfs, memory, NULL);
@@ -0,0 +1,158 @@
+/* Copyright (C) 2001-2021 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Minimal fork/join worker thread pool */
+
+#include "memory_.h"
+#include "gx.h"
+#include "gserrors.h"
+#include "gsmemory.h"
+#include "gpsync.h"
+#include "gxsync.h"
+#include "gxtpool.h"
+
+typedef struct gx_tpool_worker_s {
+    gx_tpool_t *pool;
+    int strip;
+    int code;
+    gx_semaphore_t *start;      /* signalled when there is work (or on quit) */
+    gp_thread_id thread;
+} gx_tpool_worker_t;
+
+struct gx_tpool_s {
+    gs_memory_t *memory;        /* non_gc_memory */
+    int num_strips;
+    bool quit;
+    gx_tpool_proc_t proc;       /* the current job */
+    void *arg;
+    gx_semaphore_t *done;       /* signalled once per finished strip */
+    gx_tpool_worker_t *workers; /* num_strips - 1 of them */
+    int num_workers;            /* actually started */
+};
+
+static void
+gx_tpool_worker_main(void *data)
+{
+    gx_tpool_worker_t *w = (gx_tpool_worker_t *)data;
+    gx_tpool_t *pool = w->pool;
+
+    for (;;) {
+        gx_semaphore_wait(w->start);
+        if (pool->quit)
+            break;
+        w->code = pool->proc(pool->arg, w->strip, pool->num_strips);
+        gx_semaphore_signal(pool->done);
+    }
+}
+
+int
+gx_tpool_alloc(gs_memory_t *mem, int num_strips, gx_tpool_t **ppool)
+{
+    gx_tpool_t *pool;
+    int k, code = 0;
+
+    *ppool = NULL;
+    if (num_strips < 2)
+        return_error(gs_error_rangecheck);
+    mem = mem->non_gc_memory;
+    pool = (gx_tpool_t *)gs_alloc_bytes(mem, sizeof(gx_tpool_t),
+                                        "gx_tpool_alloc");
+    if (pool == NULL)
+        return_error(gs_error_VMerror);
+    memset(pool, 0, sizeof(*pool));
+    pool->memory = mem;
+    pool->num_strips = num_strips;
+    pool->workers = (gx_tpool_worker_t *)gs_alloc_bytes(mem,
+                          (num_strips - 1) * sizeof(gx_tpool_worker_t),
+                          "gx_tpool_alloc(workers)");
+    pool->done = gx_semaphore_label(gx_semaphore_alloc(mem), "tpool done");
+    if (pool->workers == NULL || pool->done == NULL) {
+        gx_tpool_free(pool);
+        return_error(gs_error_VMerror);
+    }
+    memset(pool->workers, 0, (num_strips - 1) * sizeof(gx_tpool_worker_t));
+    for (k = 0; k < num_strips - 1; k++) {
+        gx_tpool_worker_t *w = &pool->workers[k];
+
+        w->pool = pool;
+        w->strip = k;
+        w->start = gx_semaphore_label(gx_semaphore_alloc(mem), "tpool start");
+        if (w->start == NULL) {
+            code = gs_note_error(gs_error_VMerror);
+            break;
+        }
+        code = gp_thread_start(gx_tpool_worker_main, w, &w->thread);
+        if (code < 0) {
+            gx_semaphore_free(w->start);
+            w->start = NULL;
+            break;
+        }
+        gp_thread_label(w->thread, "tpool worker");
+        pool->num_workers++;
+    }
+    if (code < 0) {
+        gx_tpool_free(pool);
+        return code;
+    }
+    *ppool = pool;
+    return 0;
+}
+
+int
+gx_tpool_num_strips(const gx_tpool_t *pool)
+{
+    return pool->num_strips;
+}
+
+int
+gx_tpool_run(gx_tpool_t *pool, gx_tpool_proc_t proc, void *arg)
+{
+    int k, code;
+
+    pool->proc = proc;
+    pool->arg = arg;
+    for (k = 0; k < pool->num_workers; k++)
+        gx_semaphore_signal(pool->workers[k].start);
+    /* The calling thread takes the last strip. */
+    code = proc(arg, pool->num_strips - 1, pool->num_strips);
+    for (k = 0; k < pool->num_workers; k++)
+        gx_semaphore_wait(pool->done);
+    for (k = 0; k < pool->num_workers; k++)
+        if (code >= 0 && pool->workers[k].code < 0)
+            code = pool->workers[k].code;
+    return code;
+}
+
+void
+gx_tpool_free(gx_tpool_t *pool)
+{
+    gs_memory_t *mem;
+    int k;
+
+    if (pool == NULL)
+        return;
+    mem = pool->memory;
+    pool->quit = true;
+    for (k = 0; k < pool->num_workers; k++)
+        gx_semaphore_signal(pool->workers[k].start);
+    for (k = 0; k < pool->num_workers; k++) {
+        gp_thread_finish(pool->workers[k].thread);
+        gx_semaphore_free(pool->workers[k].start);
+    }
+    gx_semaphore_free(pool->done);
+    gs_free_object(mem, pool->workers, "gx_tpool_free(workers)");
+    gs_free_object(mem, pool, "gx_tpool_free");
+}
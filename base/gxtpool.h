@@ -0,0 +1,52 @@
+/* Copyright (C) 2001-2021 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Interface to a minimal fork/join worker thread pool */
+
+#ifndef gxtpool_INCLUDED
+#  define gxtpool_INCLUDED
+
+#include "gsmemory.h"
+
+/*
+ * A worker pool splits one job into a fixed number of strips.  Strips
+ * 0 .. num_strips - 2 are handed to worker threads, the last strip is run
+ * on the calling thread, and gx_tpool_run returns once all of them have
+ * finished.  The job procedure must not use the (non thread safe) gs
+ * allocators or touch any state shared with other strips other than for
+ * reading.
+ *
+ * Pools are allocated from non_gc_memory.  If the platform has no thread
+ * support (gp_nsync.c), gx_tpool_alloc fails and callers are expected to
+ * do the work serially instead.
+ */
+typedef struct gx_tpool_s gx_tpool_t;
+
+typedef int (*gx_tpool_proc_t)(void *arg, int strip, int num_strips);
+
+/* Allocate a pool that will run jobs as num_strips strips, i.e. */
+/* with num_strips - 1 worker threads. */
+int gx_tpool_alloc(gs_memory_t *mem, int num_strips, gx_tpool_t **ppool);
+
+/* Run proc over all the strips; returns the first error, if any. */
+int gx_tpool_run(gx_tpool_t *pool, gx_tpool_proc_t proc, void *arg);
+
+int gx_tpool_num_strips(const gx_tpool_t *pool);
+
+/* Stop the worker threads and free the pool. */
+void gx_tpool_free(gx_tpool_t *pool);
+
+#endif /* gxtpool_INCLUDED */
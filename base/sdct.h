@@ -54,6 +54,7 @@
         gs_memory_t *cmem;	/* chunk allocator for library allocations */\
         byte *dummy;   /* see comment above */\
         int Height; /* For JPEG files using a DNL (Define Number of Lines) marker */\
+        int ScaleDenom; /* DCTDecode only: 1, or 2, 4, 8 to decode at reduced size */\
                 /* The following are documented in Adobe TN 5116. */\
         int Picky;		/* 0 or 1 */\
         int Relax		/* 0 or 1 */
@@ -66,6 +67,7 @@ typedef struct jpeg_stream_data_s {
 #define jpeg_stream_data_common_init(pdata)\
 BEGIN\
   (pdata)->Height = 0;\
+  (pdata)->ScaleDenom = 1;\
   (pdata)->Picky = 0;\
   (pdata)->Relax = 0;\
   (pdata)->dummy = 0;\
@@ -280,6 +280,16 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
                 /* out_color_space will default to JCS_CMYK */
                 break;
             }
+#ifdef GS_JPEG_BOX_UPSAMPLING
+            jddp->dinfo.do_fancy_upsampling = FALSE;
+#endif
+            /* Let the library's reduced-size IDCT do the scaling if the
+             * client has asked for a smaller image.
+             */
+            if (jddp->ScaleDenom > 1) {
+                jddp->dinfo.scale_num = 1;
+                jddp->dinfo.scale_denom = jddp->ScaleDenom;
+            }
             ss->phase = 2;
             /* falls through */
         case 2:		/* start_decompress */
@@ -294,6 +304,15 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
                     (jddp->PassThroughfn)(jddp->device, Buf, pr->ptr - (Buf - 1));
                 return 0;
             }
+            /* A library built without IDCT scaling ignores scale_denom;
+             * the client has already been told the reduced size.
+             */
+            if (jddp->ScaleDenom > 1 &&
+                jddp->dinfo.output_width !=
+                    (jddp->dinfo.image_width + jddp->ScaleDenom - 1) / jddp->ScaleDenom) {
+                code = ERRC;
+                goto error_out;
+            }
             ss->scan_line_size =
                 jddp->dinfo.output_width * jddp->dinfo.output_components;
             if_debug4m('w', ss->memory, "[wdd]width=%u, components=%d, scan_line_size=%u, min_out_size=%u\n",
@@ -64,7 +64,8 @@ static int opj_lock(gs_memory_t *mem)
 
     ret = gx_monitor_enter((gx_monitor_t *)ctx->sjpxd_private);
     assert(opj_memory == NULL);
-    opj_memory = mem->non_gc_memory;
+    /* OpenJPEG's worker threads allocate too, so this must be thread safe */
+    opj_memory = mem->thread_safe_memory;
     return ret;
 #else
     return 0;
@@ -312,6 +313,23 @@ s_opjd_set_codec_format(stream_state * ss, OPJ_CODEC_FORMAT format)
     return 0;
 }
 
+/* Free the decoder handle and the byte stream. OpenJPEG's worker threads
+   belong to the decoder handle, and are joined here, so this must be done
+   before opj_unlock(): an idle worker still allocates through opj_memory.
+ */
+static void
+s_opjd_free_codec(stream_jpxd_state * const state)
+{
+    if (state->stream) {
+        opj_stream_destroy(state->stream);
+        state->stream = NULL;
+    }
+    if (state->codec) {
+        opj_destroy_codec(state->codec);
+        state->codec = NULL;
+    }
+}
+
 static void
 ycc_to_rgb_8(unsigned char *row, unsigned long row_size)
 {
@@ -385,6 +403,79 @@ ycc_to_rgb_16(unsigned char *row, unsigned long row_size)
     while (row_size);
 }
 
+/* Ask the codec for the resolution and area the client wants */
+static int set_reduced_decode(stream_jpxd_state * const state)
+{
+    opj_image_t *image = state->image;
+    int reduce = state->reduce, compno;
+
+    if (reduce > 0) {
+        opj_codestream_info_v2_t *info = opj_get_cstr_info(state->codec);
+
+        /* Can't discard more levels than the main header has. If the
+         * result is larger than the client expects, we resample later.
+         */
+        if (info == NULL || info->m_default_tile_info.tccp_info == NULL)
+            reduce = 0;
+        else {
+            for (compno = 0; compno < info->nbcomps; compno++) {
+                int numres = info->m_default_tile_info.tccp_info[compno].numresolutions;
+
+                if (reduce > numres - 1)
+                    reduce = numres - 1;
+            }
+        }
+        if (info != NULL)
+            opj_destroy_cstr_info(&info);
+        if (reduce > 0 && !opj_set_decoded_resolution_factor(state->codec, reduce))
+            return ERRC;
+    }
+    if (state->has_area) {
+        if (!opj_set_decode_area(state->codec, image,
+                                 image->x0 + state->area_x0, image->y0 + state->area_y0,
+                                 image->x0 + state->area_x1, image->y0 + state->area_y1))
+            return ERRC;
+    }
+    return 0;
+}
+
+/* Nearest neighbour resample of the decoded components to the size the
+ * client was promised, for when the codec couldn't reduce as far as asked
+ * (or rounded the area differently).
+ */
+static int resample_to_out_size(stream_jpxd_state * const state)
+{
+    opj_image_t *image = state->image;
+    OPJ_UINT32 w = image->comps[0].w, h = image->comps[0].h;
+    OPJ_UINT32 ow = state->out_width, oh = state->out_height, x, y;
+    int compno;
+
+    for (compno = 1; compno < image->numcomps; compno++)
+        if (image->comps[compno].w != w || image->comps[compno].h != h)
+            return ERRC;        /* Not supported. */
+    if (w == 0 || h == 0)
+        return ERRC;
+
+    for (compno = 0; compno < image->numcomps; compno++) {
+        OPJ_INT32 *src = image->comps[compno].data, *dst;
+
+        dst = (OPJ_INT32 *)opj_image_data_alloc((OPJ_SIZE_T)ow * oh * sizeof(OPJ_INT32));
+        if (dst == NULL)
+            return_error(gs_error_VMerror);
+        for (y = 0; y < oh; y++) {
+            OPJ_INT32 *srow = src + (OPJ_SIZE_T)((OPJ_UINT64)y * h / oh) * w;
+
+            for (x = 0; x < ow; x++)
+                dst[(OPJ_SIZE_T)y * ow + x] = srow[(OPJ_UINT64)x * w / ow];
+        }
+        opj_image_data_free(src);
+        image->comps[compno].data = dst;
+        image->comps[compno].w = ow;
+        image->comps[compno].h = oh;
+    }
+    return 0;
+}
+
 static int decode_image(stream_jpxd_state * const state)
 {
     int numprimcomp = 0, alpha_comp = -1, compno, rowbytes;
@@ -396,6 +487,13 @@ static int decode_image(stream_jpxd_state * const state)
     	return ERRC;
     }
 
+    if (state->reduce > 0 || state->has_area) {
+        if (set_reduced_decode(state) < 0) {
+            dlprintf("openjpeg: failed to set reduced decode!\n");
+            return ERRC;
+        }
+    }
+
     /* decode the stream and fill the image structure */
     if (!opj_decode(state->codec, state->stream, state->image))
     {
@@ -407,6 +505,15 @@ static int decode_image(stream_jpxd_state * const state)
     if (state->image->numcomps == 0)
         return ERRC;
 
+    if (state->out_width > 0 &&
+        ((int)state->image->comps[0].w != state->out_width ||
+         (int)state->image->comps[0].h != state->out_height)) {
+        int code = resample_to_out_size(state);
+
+        if (code < 0)
+            return code;
+    }
+
     state->width = state->image->comps[0].w;
     state->height = state->image->comps[0].h;
     state->bpp = state->image->comps[0].prec;
@@ -696,7 +803,6 @@ s_opjd_process(stream_state * ss, stream_cursor_read * pr,
 {
     stream_jpxd_state *const state = (stream_jpxd_state *) ss;
     long in_size = pr->limit - pr->ptr;
-    int locked = 0;
     int code;
 
     if (in_size > 0)
@@ -710,26 +816,8 @@ s_opjd_process(stream_state * ss, stream_cursor_read * pr,
         }
 
         /* buffer available data */
-        code = opj_lock(ss->memory);
-        if (code < 0) return code;
-        locked = 1;
-
         code = s_opjd_accumulate_input(state, pr);
         if (code < 0) return code;
-
-        if (state->codec == NULL) {
-            /* state->sb.size is non-zero after successful
-               accumulate_input(); 1 is probably extremely rare */
-            if (state->sb.data[0] == 0xFF && ((state->sb.size == 1) || (state->sb.data[1] == 0x4F)))
-                code = s_opjd_set_codec_format(ss, OPJ_CODEC_J2K);
-            else
-                code = s_opjd_set_codec_format(ss, OPJ_CODEC_JP2);
-            if (code < 0)
-            {
-                (void)opj_unlock(ss->memory);
-                return code;
-            }
-        }
     }
 
     if (last == 1)
@@ -738,30 +826,31 @@ s_opjd_process(stream_state * ss, stream_cursor_read * pr,
         {
             int ret;
 
-            if (locked == 0)
-            {
-                ret = opj_lock(ss->memory);
-                if (ret < 0) return ret;
-                locked = 1;
-            }
+            /* The decoder handle (and so OpenJPEG's thread pool) only exists
+               while we hold the lock, see s_opjd_free_codec(). */
+            ret = opj_lock(ss->memory);
+            if (ret < 0) return ret;
 
+            /* state->sb.size is non-zero after successful
+               accumulate_input(); 1 is probably extremely rare */
+            if (state->sb.size > 0 && state->sb.data[0] == 0xFF &&
+                ((state->sb.size == 1) || (state->sb.data[1] == 0x4F)))
+                ret = s_opjd_set_codec_format(ss, OPJ_CODEC_J2K);
+            else
+                ret = s_opjd_set_codec_format(ss, OPJ_CODEC_JP2);
+            if (ret >= 0) {
 #if OPJ_VERSION_MAJOR >= 2 && OPJ_VERSION_MINOR >= 1
-            opj_stream_set_user_data(state->stream, &(state->sb), NULL);
+                opj_stream_set_user_data(state->stream, &(state->sb), NULL);
 #else
-            opj_stream_set_user_data(state->stream, &(state->sb));
+                opj_stream_set_user_data(state->stream, &(state->sb));
 #endif
-            opj_stream_set_user_data_length(state->stream, state->sb.size);
-            ret = decode_image(state);
-            if (ret != 0)
-            {
-                (void)opj_unlock(ss->memory);
-                return ret;
+                opj_stream_set_user_data_length(state->stream, state->sb.size);
+                ret = decode_image(state);
             }
-        }
-
-        if (locked)
-        {
+            s_opjd_free_codec(state);
             code = opj_unlock(ss->memory);
+            if (ret != 0)
+                return ret;
             if (code < 0) return code;
         }
 
@@ -770,9 +859,6 @@ s_opjd_process(stream_state * ss, stream_cursor_read * pr,
 
     }
 
-    if (locked)
-        return opj_unlock(ss->memory);
-
     /* ask for more data */
     return 0;
 }
@@ -788,6 +874,9 @@ s_opjd_set_defaults(stream_state * ss) {
     state->PassThrough = 0;
     state->PassThroughfn = NULL;
     state->device = (void *)NULL;
+    state->reduce = 0;
+    state->has_area = false;
+    state->out_width = state->out_height = 0;
 }
 
 /* stream release.
@@ -802,25 +891,18 @@ s_opjd_release(stream_state *ss)
         state->StartedPassThrough = 0;
         (state->PassThroughfn)(state->device, NULL, 0);
     }
-    /* empty stream or failed to accumulate */
-    if (state->codec == NULL)
-        return;
+    if (state->image != NULL || state->codec != NULL) {
+        (void)opj_lock(ss->memory);
 
-    (void)opj_lock(ss->memory);
+        /* free image data structure */
+        if (state->image)
+            opj_image_destroy(state->image);
+        state->image = NULL;
 
-    /* free image data structure */
-    if (state->image)
-        opj_image_destroy(state->image);
+        s_opjd_free_codec(state);
 
-    /* free stream */
-    if (state->stream)
-        opj_stream_destroy(state->stream);
-
-    /* free decoder handle */
-    if (state->codec)
-	opj_destroy_codec(state->codec);
-
-    (void)opj_unlock(ss->memory);
+        (void)opj_unlock(ss->memory);
+    }
 
     /* free input buffer */
     if (state->sb.data)
@@ -72,6 +72,16 @@ typedef struct stream_jpxd_state_s
 
     unsigned char *row_data;
 
+    /* A client that draws the image small or clipped can set these before
+     * the first read to have the codec do less work. The image is then
+     * returned at out_width x out_height, which must be what the client
+     * expects for the reduction and area it asked for.
+     */
+    int reduce;                         /* resolution levels to discard */
+    bool has_area;
+    int area_x0, area_y0, area_x1, area_y1; /* full resolution samples */
+    int out_width, out_height;          /* 0 for the decoded size */
+
     int PassThrough;                    /* 0 or 1 */
     bool StartedPassThrough;            /* Don't signal multiple starts for the same decode */
     JPXD_PassThrough((*PassThroughfn)); /* We don't want the stream code or
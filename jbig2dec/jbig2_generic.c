@@ -361,6 +361,59 @@ jbig2_generic_stats_size(Jbig2Ctx *ctx, int template)
     return stats_size;
 }
 
+/* Decode row y of a generic region with GBTEMPLATE 0 and the nominal
+ * adaptive pixels. The context is kept in sliding windows over the two
+ * rows above (see the description of the optimized decoders at the top
+ * of this file). Used for every row by jbig2_decode_generic_template0(),
+ * and for the rows which are not typical predictions when TPGDON is set.
+ */
+static int
+jbig2_decode_generic_template0_line(Jbig2Ctx *ctx, Jbig2Segment *segment, Jbig2ArithState *as,
+                                    Jbig2Image *image, Jbig2ArithCx *GB_stats, uint32_t y)
+{
+    const uint32_t GBW = image->width;
+    const uint32_t rowstride = image->stride;
+    byte *gbreg_line = (byte *) image->data + (size_t) y * rowstride;
+    const byte *line1 = y > 0 ? gbreg_line - rowstride : NULL;
+    const byte *line2 = y > 1 ? gbreg_line - 2 * rowstride : NULL;
+    uint32_t CONTEXT;
+    uint32_t line_m1;
+    uint32_t line_m2;
+    uint32_t padded_width = (GBW + 7) & -8;
+    uint32_t x;
+
+    line_m1 = line1 ? line1[0] : 0;
+    line_m2 = line2 ? line2[0] << 6 : 0;
+    CONTEXT = (line_m1 & 0x7f0) | (line_m2 & 0xf800);
+
+    /* 6.2.5.7 3d */
+    for (x = 0; x < padded_width; x += 8) {
+        byte result = 0;
+        int x_minor;
+        int minor_width = GBW - x > 8 ? 8 : GBW - x;
+
+        if (line1)
+            line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
+
+        if (line2)
+            line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 6 : 0);
+
+        /* This is the speed-critical inner loop. */
+        for (x_minor = 0; x_minor < minor_width; x_minor++) {
+            int bit;
+
+            bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
+            if (bit < 0)
+                return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template0 optimized");
+            result |= bit << (7 - x_minor);
+            CONTEXT = ((CONTEXT & 0x7bf7) << 1) | bit | ((line_m1 >> (7 - x_minor)) & 0x10) | ((line_m2 >> (7 - x_minor)) & 0x800);
+        }
+        gbreg_line[x >> 3] = result;
+    }
+
+    return 0;
+}
+
 static int
 jbig2_decode_generic_template0(Jbig2Ctx *ctx,
                                Jbig2Segment *segment,
@@ -369,11 +422,11 @@ jbig2_decode_generic_template0(Jbig2Ctx *ctx,
 {
     const uint32_t GBW = image->width;
     const uint32_t GBH = image->height;
+#ifdef OUTPUT_PBM
     const uint32_t rowstride = image->stride;
-    uint32_t x, y;
-    byte *line2 = NULL;
-    byte *line1 = NULL;
-    byte *gbreg_line = (byte *) image->data;
+#endif
+    uint32_t y;
+    int code;
 
 #ifdef OUTPUT_PBM
     printf("P4\n%d %d\n", GBW, GBH);
@@ -383,45 +436,12 @@ jbig2_decode_generic_template0(Jbig2Ctx *ctx,
         return 0;
 
     for (y = 0; y < GBH; y++) {
-        uint32_t CONTEXT;
-        uint32_t line_m1;
-        uint32_t line_m2;
-        uint32_t padded_width = (GBW + 7) & -8;
-
-        line_m1 = line1 ? line1[0] : 0;
-        line_m2 = line2 ? line2[0] << 6 : 0;
-        CONTEXT = (line_m1 & 0x7f0) | (line_m2 & 0xf800);
-
-        /* 6.2.5.7 3d */
-        for (x = 0; x < padded_width; x += 8) {
-            byte result = 0;
-            int x_minor;
-            int minor_width = GBW - x > 8 ? 8 : GBW - x;
-
-            if (line1)
-                line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
-
-            if (line2)
-                line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 6 : 0);
-
-            /* This is the speed-critical inner loop. */
-            for (x_minor = 0; x_minor < minor_width; x_minor++) {
-                int bit;
-
-                bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
-                if (bit < 0)
-                    return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template0 optimized");
-                result |= bit << (7 - x_minor);
-                CONTEXT = ((CONTEXT & 0x7bf7) << 1) | bit | ((line_m1 >> (7 - x_minor)) & 0x10) | ((line_m2 >> (7 - x_minor)) & 0x800);
-            }
-            gbreg_line[x >> 3] = result;
-        }
+        code = jbig2_decode_generic_template0_line(ctx, segment, as, image, GB_stats, y);
+        if (code < 0)
+            return code;
 #ifdef OUTPUT_PBM
-        fwrite(gbreg_line, 1, rowstride, stdout);
+        fwrite(image->data + (size_t) y * rowstride, 1, rowstride, stdout);
 #endif
-        line2 = line1;
-        line1 = gbreg_line;
-        gbreg_line += rowstride;
     }
 
     return 0;
@@ -568,6 +588,54 @@ jbig2_decode_generic_template1_unopt(Jbig2Ctx *ctx,
     return 0;
 }
 
+/* As jbig2_decode_generic_template0_line(), for GBTEMPLATE 1. */
+static int
+jbig2_decode_generic_template1_line(Jbig2Ctx *ctx, Jbig2Segment *segment, Jbig2ArithState *as,
+                                    Jbig2Image *image, Jbig2ArithCx *GB_stats, uint32_t y)
+{
+    const uint32_t GBW = image->width;
+    const uint32_t rowstride = image->stride;
+    byte *gbreg_line = (byte *) image->data + (size_t) y * rowstride;
+    const byte *line1 = y > 0 ? gbreg_line - rowstride : NULL;
+    const byte *line2 = y > 1 ? gbreg_line - 2 * rowstride : NULL;
+    uint32_t CONTEXT;
+    uint32_t line_m1;
+    uint32_t line_m2;
+    uint32_t padded_width = (GBW + 7) & -8;
+    uint32_t x;
+
+    line_m1 = line1 ? line1[0] : 0;
+    line_m2 = line2 ? line2[0] << 5 : 0;
+    CONTEXT = ((line_m1 >> 1) & 0x1f8) | ((line_m2 >> 1) & 0x1e00);
+
+    /* 6.2.5.7 3d */
+    for (x = 0; x < padded_width; x += 8) {
+        byte result = 0;
+        int x_minor;
+        int minor_width = GBW - x > 8 ? 8 : GBW - x;
+
+        if (line1)
+            line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
+
+        if (line2)
+            line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 5 : 0);
+
+        /* This is the speed-critical inner loop. */
+        for (x_minor = 0; x_minor < minor_width; x_minor++) {
+            int bit;
+
+            bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
+            if (bit < 0)
+                return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template1 optimized");
+            result |= bit << (7 - x_minor);
+            CONTEXT = ((CONTEXT & 0xefb) << 1) | bit | ((line_m1 >> (8 - x_minor)) & 0x8) | ((line_m2 >> (8 - x_minor)) & 0x200);
+        }
+        gbreg_line[x >> 3] = result;
+    }
+
+    return 0;
+}
+
 static int
 jbig2_decode_generic_template1(Jbig2Ctx *ctx,
                                Jbig2Segment *segment,
@@ -575,11 +643,11 @@ jbig2_decode_generic_template1(Jbig2Ctx *ctx,
 {
     const uint32_t GBW = image->width;
     const uint32_t GBH = image->height;
+#ifdef OUTPUT_PBM
     const uint32_t rowstride = image->stride;
-    uint32_t x, y;
-    byte *line2 = NULL;
-    byte *line1 = NULL;
-    byte *gbreg_line = (byte *) image->data;
+#endif
+    uint32_t y;
+    int code;
 
 #ifdef OUTPUT_PBM
     printf("P4\n%d %d\n", GBW, GBH);
@@ -589,45 +657,12 @@ jbig2_decode_generic_template1(Jbig2Ctx *ctx,
         return 0;
 
     for (y = 0; y < GBH; y++) {
-        uint32_t CONTEXT;
-        uint32_t line_m1;
-        uint32_t line_m2;
-        uint32_t padded_width = (GBW + 7) & -8;
-
-        line_m1 = line1 ? line1[0] : 0;
-        line_m2 = line2 ? line2[0] << 5 : 0;
-        CONTEXT = ((line_m1 >> 1) & 0x1f8) | ((line_m2 >> 1) & 0x1e00);
-
-        /* 6.2.5.7 3d */
-        for (x = 0; x < padded_width; x += 8) {
-            byte result = 0;
-            int x_minor;
-            int minor_width = GBW - x > 8 ? 8 : GBW - x;
-
-            if (line1)
-                line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
-
-            if (line2)
-                line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 5 : 0);
-
-            /* This is the speed-critical inner loop. */
-            for (x_minor = 0; x_minor < minor_width; x_minor++) {
-                int bit;
-
-                bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
-                if (bit < 0)
-                    return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template1 optimized");
-                result |= bit << (7 - x_minor);
-                CONTEXT = ((CONTEXT & 0xefb) << 1) | bit | ((line_m1 >> (8 - x_minor)) & 0x8) | ((line_m2 >> (8 - x_minor)) & 0x200);
-            }
-            gbreg_line[x >> 3] = result;
-        }
+        code = jbig2_decode_generic_template1_line(ctx, segment, as, image, GB_stats, y);
+        if (code < 0)
+            return code;
 #ifdef OUTPUT_PBM
-        fwrite(gbreg_line, 1, rowstride, stdout);
+        fwrite(image->data + (size_t) y * rowstride, 1, rowstride, stdout);
 #endif
-        line2 = line1;
-        line1 = gbreg_line;
-        gbreg_line += rowstride;
     }
 
     return 0;
@@ -700,6 +735,54 @@ jbig2_decode_generic_template2_unopt(Jbig2Ctx *ctx,
     return 0;
 }
 
+/* As jbig2_decode_generic_template0_line(), for GBTEMPLATE 2. */
+static int
+jbig2_decode_generic_template2_line(Jbig2Ctx *ctx, Jbig2Segment *segment, Jbig2ArithState *as,
+                                    Jbig2Image *image, Jbig2ArithCx *GB_stats, uint32_t y)
+{
+    const uint32_t GBW = image->width;
+    const uint32_t rowstride = image->stride;
+    byte *gbreg_line = (byte *) image->data + (size_t) y * rowstride;
+    const byte *line1 = y > 0 ? gbreg_line - rowstride : NULL;
+    const byte *line2 = y > 1 ? gbreg_line - 2 * rowstride : NULL;
+    uint32_t CONTEXT;
+    uint32_t line_m1;
+    uint32_t line_m2;
+    uint32_t padded_width = (GBW + 7) & -8;
+    uint32_t x;
+
+    line_m1 = line1 ? line1[0] : 0;
+    line_m2 = line2 ? line2[0] << 4 : 0;
+    CONTEXT = ((line_m1 >> 3) & 0x7c) | ((line_m2 >> 3) & 0x380);
+
+    /* 6.2.5.7 3d */
+    for (x = 0; x < padded_width; x += 8) {
+        byte result = 0;
+        int x_minor;
+        int minor_width = GBW - x > 8 ? 8 : GBW - x;
+
+        if (line1)
+            line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
+
+        if (line2)
+            line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 4 : 0);
+
+        /* This is the speed-critical inner loop. */
+        for (x_minor = 0; x_minor < minor_width; x_minor++) {
+            int bit;
+
+            bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
+            if (bit < 0)
+                return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template2 optimized");
+            result |= bit << (7 - x_minor);
+            CONTEXT = ((CONTEXT & 0x1bd) << 1) | bit | ((line_m1 >> (10 - x_minor)) & 0x4) | ((line_m2 >> (10 - x_minor)) & 0x80);
+        }
+        gbreg_line[x >> 3] = result;
+    }
+
+    return 0;
+}
+
 static int
 jbig2_decode_generic_template2(Jbig2Ctx *ctx,
                                 Jbig2Segment *segment,
@@ -707,11 +790,11 @@ jbig2_decode_generic_template2(Jbig2Ctx *ctx,
 {
     const uint32_t GBW = image->width;
     const uint32_t GBH = image->height;
+#ifdef OUTPUT_PBM
     const uint32_t rowstride = image->stride;
-    uint32_t x, y;
-    byte *line2 = NULL;
-    byte *line1 = NULL;
-    byte *gbreg_line = (byte *) image->data;
+#endif
+    uint32_t y;
+    int code;
 
 #ifdef OUTPUT_PBM
     printf("P4\n%d %d\n", GBW, GBH);
@@ -721,45 +804,54 @@ jbig2_decode_generic_template2(Jbig2Ctx *ctx,
         return 0;
 
     for (y = 0; y < GBH; y++) {
-        uint32_t CONTEXT;
-        uint32_t line_m1;
-        uint32_t line_m2;
-        uint32_t padded_width = (GBW + 7) & -8;
+        code = jbig2_decode_generic_template2_line(ctx, segment, as, image, GB_stats, y);
+        if (code < 0)
+            return code;
+#ifdef OUTPUT_PBM
+        fwrite(image->data + (size_t) y * rowstride, 1, rowstride, stdout);
+#endif
+    }
 
-        line_m1 = line1 ? line1[0] : 0;
-        line_m2 = line2 ? line2[0] << 4 : 0;
-        CONTEXT = ((line_m1 >> 3) & 0x7c) | ((line_m2 >> 3) & 0x380);
+    return 0;
+}
 
-        /* 6.2.5.7 3d */
-        for (x = 0; x < padded_width; x += 8) {
-            byte result = 0;
-            int x_minor;
-            int minor_width = GBW - x > 8 ? 8 : GBW - x;
+/* As jbig2_decode_generic_template0_line(), for GBTEMPLATE 3. */
+static int
+jbig2_decode_generic_template3_line(Jbig2Ctx *ctx, Jbig2Segment *segment, Jbig2ArithState *as,
+                                    Jbig2Image *image, Jbig2ArithCx *GB_stats, uint32_t y)
+{
+    const uint32_t GBW = image->width;
+    const uint32_t rowstride = image->stride;
+    byte *gbreg_line = (byte *) image->data + (size_t) y * rowstride;
+    const byte *line1 = y > 0 ? gbreg_line - rowstride : NULL;
+    uint32_t CONTEXT;
+    uint32_t line_m1;
+    uint32_t padded_width = (GBW + 7) & -8;
+    uint32_t x;
 
-            if (line1)
-                line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
+    line_m1 = line1 ? line1[0] : 0;
+    CONTEXT = (line_m1 >> 1) & 0x3f0;
 
-            if (line2)
-                line_m2 = (line_m2 << 8) | (x + 8 < GBW ? line2[(x >> 3) + 1] << 4 : 0);
+    /* 6.2.5.7 3d */
+    for (x = 0; x < padded_width; x += 8) {
+        byte result = 0;
+        int x_minor;
+        int minor_width = GBW - x > 8 ? 8 : GBW - x;
 
-            /* This is the speed-critical inner loop. */
-            for (x_minor = 0; x_minor < minor_width; x_minor++) {
-                int bit;
+        if (line1)
+            line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
 
-                bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
-                if (bit < 0)
-                    return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template2 optimized");
-                result |= bit << (7 - x_minor);
-                CONTEXT = ((CONTEXT & 0x1bd) << 1) | bit | ((line_m1 >> (10 - x_minor)) & 0x4) | ((line_m2 >> (10 - x_minor)) & 0x80);
-            }
-            gbreg_line[x >> 3] = result;
+        /* This is the speed-critical inner loop. */
+        for (x_minor = 0; x_minor < minor_width; x_minor++) {
+            int bit;
+
+            bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
+            if (bit < 0)
+                return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template3 optimized");
+            result |= bit << (7 - x_minor);
+            CONTEXT = ((CONTEXT & 0x1f7) << 1) | bit | ((line_m1 >> (8 - x_minor)) & 0x10);
         }
-#ifdef OUTPUT_PBM
-        fwrite(gbreg_line, 1, rowstride, stdout);
-#endif
-        line2 = line1;
-        line1 = gbreg_line;
-        gbreg_line += rowstride;
+        gbreg_line[x >> 3] = result;
     }
 
     return 0;
@@ -772,10 +864,11 @@ jbig2_decode_generic_template3(Jbig2Ctx *ctx,
 {
     const uint32_t GBW = image->width;
     const uint32_t GBH = image->height;
+#ifdef OUTPUT_PBM
     const uint32_t rowstride = image->stride;
-    byte *line1 = NULL;
-    byte *gbreg_line = (byte *) image->data;
-    uint32_t x, y;
+#endif
+    uint32_t y;
+    int code;
 
 #ifdef OUTPUT_PBM
     printf("P4\n%d %d\n", GBW, GBH);
@@ -785,39 +878,12 @@ jbig2_decode_generic_template3(Jbig2Ctx *ctx,
         return 0;
 
     for (y = 0; y < GBH; y++) {
-        uint32_t CONTEXT;
-        uint32_t line_m1;
-        uint32_t padded_width = (GBW + 7) & -8;
-
-        line_m1 = line1 ? line1[0] : 0;
-        CONTEXT = (line_m1 >> 1) & 0x3f0;
-
-        /* 6.2.5.7 3d */
-        for (x = 0; x < padded_width; x += 8) {
-            byte result = 0;
-            int x_minor;
-            int minor_width = GBW - x > 8 ? 8 : GBW - x;
-
-            if (line1)
-                line_m1 = (line_m1 << 8) | (x + 8 < GBW ? line1[(x >> 3) + 1] : 0);
-
-            /* This is the speed-critical inner loop. */
-            for (x_minor = 0; x_minor < minor_width; x_minor++) {
-                int bit;
-
-                bit = jbig2_arith_decode(ctx, as, &GB_stats[CONTEXT]);
-                if (bit < 0)
-                    return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template3 optimized");
-                result |= bit << (7 - x_minor);
-                CONTEXT = ((CONTEXT & 0x1f7) << 1) | bit | ((line_m1 >> (8 - x_minor)) & 0x10);
-            }
-            gbreg_line[x >> 3] = result;
-        }
+        code = jbig2_decode_generic_template3_line(ctx, segment, as, image, GB_stats, y);
+        if (code < 0)
+            return code;
 #ifdef OUTPUT_PBM
-        fwrite(gbreg_line, 1, rowstride, stdout);
+        fwrite(image->data + (size_t) y * rowstride, 1, rowstride, stdout);
 #endif
-        line1 = gbreg_line;
-        gbreg_line += rowstride;
     }
 
     return 0;
@@ -914,7 +980,8 @@ jbig2_decode_generic_template0_TPGDON(Jbig2Ctx *ctx,
     /* JBig2 has 'standard' values for gbat (see 6.2.5.4 of the spec).
      * Have an optimised version for those locations. This greatly
      * simplifies some of the fetches. It's almost like they thought
-     * it through. */
+     * it through. Without a SKIP bitmap these are handled by the
+     * optimized row decoder instead, so we only get here with USESKIP. */
     if (params->gbat[0] ==  3 && params->gbat[1] == -1 &&
         params->gbat[2] == -3 && params->gbat[3] == -1 &&
         params->gbat[4] ==  2 && params->gbat[5] == -2 &&
@@ -1304,11 +1371,70 @@ jbig2_decode_generic_template3_TPGDON(Jbig2Ctx *ctx,
     return 0;
 }
 
+typedef int (*jbig2_generic_line_decoder)(Jbig2Ctx *ctx, Jbig2Segment *segment, Jbig2ArithState *as,
+                                          Jbig2Image *image, Jbig2ArithCx *GB_stats, uint32_t y);
+
+/* With the nominal adaptive pixels and no SKIP bitmap, the rows which are not
+ * typical predictions can be decoded by the optimized row decoders, rather than
+ * working out the whole context for every pixel. SLTP_context is the context
+ * used to decode the SLTP bit for the template (6.2.5.7 3b).
+ */
+static int
+jbig2_decode_generic_TPGDON_optimized(Jbig2Ctx *ctx,
+                                      Jbig2Segment *segment,
+                                      Jbig2ArithState *as, Jbig2Image *image, Jbig2ArithCx *GB_stats,
+                                      uint32_t SLTP_context, jbig2_generic_line_decoder decode_line)
+{
+    const uint32_t GBH = image->height;
+    uint32_t y;
+    int LTP = 0;
+    int code;
+
+    for (y = 0; y < GBH; y++) {
+        int bit = jbig2_arith_decode(ctx, as, &GB_stats[SLTP_context]);
+        if (bit < 0)
+            return jbig2_error(ctx, JBIG2_SEVERITY_WARNING, segment->number, "failed to decode arithmetic code when handling generic template TPGDON1");
+        LTP ^= bit;
+        if (!LTP) {
+            code = decode_line(ctx, segment, as, image, GB_stats, y);
+            if (code < 0)
+                return code;
+        } else {
+            copy_prev_row(image, y);
+        }
+    }
+
+    return 0;
+}
+
 static int
 jbig2_decode_generic_region_TPGDON(Jbig2Ctx *ctx,
                                    Jbig2Segment *segment,
                                    const Jbig2GenericRegionParams *params, Jbig2ArithState *as, Jbig2Image *image, Jbig2ArithCx *GB_stats)
 {
+    const int8_t *gbat = params->gbat;
+
+    if (!params->USESKIP) {
+        switch (params->GBTEMPLATE) {
+        case 0:
+            if (gbat[0] == +3 && gbat[1] == -1 && gbat[2] == -3 && gbat[3] == -1 && gbat[4] == +2 && gbat[5] == -2 && gbat[6] == -2 && gbat[7] == -2)
+                return jbig2_decode_generic_TPGDON_optimized(ctx, segment, as, image, GB_stats, 0x9B25, jbig2_decode_generic_template0_line);
+            break;
+        case 1:
+            if (gbat[0] == +3 && gbat[1] == -1)
+                return jbig2_decode_generic_TPGDON_optimized(ctx, segment, as, image, GB_stats, 0x0795, jbig2_decode_generic_template1_line);
+            break;
+        case 2:
+            if (gbat[0] == 2 && gbat[1] == -1)
+                return jbig2_decode_generic_TPGDON_optimized(ctx, segment, as, image, GB_stats, 0xE5, jbig2_decode_generic_template2_line);
+            break;
+        case 3:
+            if (gbat[0] == 2 && gbat[1] == -1)
+                return jbig2_decode_generic_TPGDON_optimized(ctx, segment, as, image, GB_stats, 0x0195, jbig2_decode_generic_template3_line);
+            break;
+        }
+    }
+
     switch (params->GBTEMPLATE) {
     case 0:
         return jbig2_decode_generic_template0_TPGDON(ctx, segment, params, as, image, GB_stats);
@@ -1769,6 +1769,10 @@ int pdfi_clear_context(pdf_context *ctx)
         gs_free_object(ctx->memory, ctx->args.PageList, "pdfi_clear_context");
         ctx->args.PageList = NULL;
     }
+    if (ctx->args.fontindex) {
+        gs_free_object(ctx->memory, ctx->args.fontindex, "pdfi_clear_context");
+        ctx->args.fontindex = NULL;
+    }
     if (ctx->Trailer) {
         pdfi_countdown(ctx->Trailer);
         ctx->Trailer = NULL;
@@ -1798,6 +1802,7 @@ int pdfi_clear_context(pdf_context *ctx)
     pdfi_free_cstring_array(ctx, &ctx->args.preserveannottypes);
 
     pdfi_doc_page_array_free(ctx);
+    pdfi_check_free_memo(ctx);
 
     if (ctx->xref_table) {
         pdfi_countdown(ctx->xref_table);
@@ -1948,6 +1953,8 @@ int pdfi_free_context(pdf_context *ctx)
     if (ctx->font_dir)
         gs_free_object(ctx->memory, ctx->font_dir, "pdfi_free_context");
 
+    pdfi_free_fontfile_cache(ctx);
+
     /* Currently this should never happen, but in future it might if we choose
      * not to keep freeing and reallocating the array.
      */
@@ -1959,6 +1966,8 @@ int pdfi_free_context(pdf_context *ctx)
     pdfi_free_search_paths(ctx);
     pdfi_free_fontmapfiles(ctx);
 
+    pdfi_free_num_pool(ctx);
+
     gs_free_object(ctx->memory, ctx, "pdfi_free_context");
 #if PDFI_LEAK_CHECK
     gs_memory_status(mem, &mstat);
@@ -154,6 +154,7 @@ typedef enum pdf_overprint_control_e {
 #define INITIAL_STACK_SIZE 32
 #define MAX_STACK_SIZE 524288
 #define MAX_OBJECT_CACHE_SIZE 200
+#define MAX_FORM_CACHE_TOKENS 1000000
 #define INITIAL_LOOP_TRACKER_SIZE 32
 
 typedef struct pdf_transfer_s {
@@ -207,10 +208,12 @@ typedef struct cmd_args_s {
     bool UsePDFX3Profile;
     bool NOSUBSTDEVICECOLORS;
     bool ditherppi;
+    bool reducejpeg;    /* decode JPEGs at reduced size when heavily downscaled */
     int PDFX3Profile_num;
     char *UseOutputIntent;
     pdf_overprint_control_t overprint_control;     /* Overprint -- enabled, disabled, simulated */
     char *PageList;
+    char *fontindex;    /* native font scan index file, NULL if none */
     bool QUIET;
     bool verbose_errors;
     bool verbose_warnings;
@@ -445,6 +448,11 @@ typedef struct pdf_context_s
     pdf_dict *PagesTree;
     uint64_t num_pages;
     uint32_t *page_array; /* cache of page dict object_num's for pdfmark Dest */
+    /* Transparency/overprint results for Resources dictionaries already checked by
+     * pdfi_check_page(), one byte per object number, see pdf_check.c
+     */
+    byte *check_memo;
+    uint32_t check_memo_size;
     pdf_dict *AcroForm;
     bool NeedAppearances; /* From AcroForm, if any */
 
@@ -458,10 +466,20 @@ typedef struct pdf_context_s
     pdf_obj **stack_top;
     pdf_obj **stack_limit;
 
+    /* Recently freed number objects, linked through their ctx member.
+     * Content streams create and discard an operand object for almost
+     * every number they contain, so we recycle them rather than going
+     * to the allocator each time.
+     */
+    pdf_obj *num_pool;
+    uint32_t num_pool_count;
+
     /* The object cache */
     uint32_t cache_entries;
     pdf_obj_cache_entry *cache_LRU;
     pdf_obj_cache_entry *cache_MRU;
+    /* Tokens held by pre-parsed Form XObjects, limited to MAX_FORM_CACHE_TOKENS */
+    uint32_t form_cache_tokens;
 
     /* The loop detection state */
     uint32_t loop_detection_size;
@@ -487,6 +505,10 @@ typedef struct pdf_context_s
     pdf_dict *pdfnativefontmap; /* Explicit mappings take precedence, hence we need separate dictionaries */
     pdf_dict *pdfcidfmap;
 
+    /* Decoded embedded font files, by content (see pdf_font.c) */
+    struct pdfi_fontfile_entry_s *fontfile_cache;
+    int64_t fontfile_cache_size;
+
     /* These function pointers can be replaced by ones intended to replicate
      * PostScript functionality when running inside the Ghostscript PostScript
      * interpreter.
@@ -109,6 +109,77 @@ static inline bool resource_is_checked(pdfi_check_tracker_t *tracker, pdf_obj *o
     return false;
 }
 
+/* The CheckedResources bitmap only lives for the duration of a single page check, so
+ * a Resources dictionary shared by every page of a document would still be walked
+ * once per page. To avoid that we also remember, for the life of the document, what
+ * checking each (indirect) Resources dictionary found.
+ *
+ * We only do this when we aren't collecting spot colours; spot colour spaces can be
+ * named resources looked up through the page dictionary, so those results are page
+ * dependent. Additionally the checks stop looking once they find transparency, so a
+ * result is only recorded when the dictionary was checked with nothing yet found
+ * (and so is complete), and only used when transparency hasn't yet been found (so
+ * that checking it again could not have stopped any earlier).
+ */
+#define CHECK_MEMO_DONE         0x01
+#define CHECK_MEMO_TRANSPARENT  0x02
+#define CHECK_MEMO_OVERPRINT    0x04
+
+void pdfi_check_free_memo(pdf_context *ctx)
+{
+    gs_free_object(ctx->memory, ctx->check_memo, "pdfi_check_free_memo");
+    ctx->check_memo = NULL;
+    ctx->check_memo_size = 0;
+}
+
+static bool resource_is_memoised(pdf_context *ctx, pdfi_check_tracker_t *tracker, pdf_obj *o)
+{
+    byte memo;
+
+    if (ctx->check_memo == NULL || tracker->spot_dict != NULL || tracker->transparent)
+        return false;
+
+    if (o->object_num == 0 || o->object_num >= ctx->check_memo_size)
+        return false;
+
+    memo = ctx->check_memo[o->object_num];
+    if (!(memo & CHECK_MEMO_DONE))
+        return false;
+
+    if (memo & CHECK_MEMO_TRANSPARENT)
+        tracker->transparent = true;
+    if (memo & CHECK_MEMO_OVERPRINT)
+        tracker->has_overprint = true;
+    return true;
+}
+
+static void resource_memoise(pdf_context *ctx, pdfi_check_tracker_t *tracker, pdf_obj *o)
+{
+    byte memo = CHECK_MEMO_DONE;
+
+    if (o->object_num == 0)
+        return;
+
+    if (ctx->check_memo == NULL) {
+        if (ctx->xref_table == NULL)
+            return;
+        ctx->check_memo = gs_alloc_bytes(ctx->memory, ctx->xref_table->xref_size,
+                                         "resource_memoise");
+        /* This is purely an optimisation, if we can't get the memory just carry on */
+        if (ctx->check_memo == NULL)
+            return;
+        memset(ctx->check_memo, 0x00, ctx->xref_table->xref_size);
+        ctx->check_memo_size = ctx->xref_table->xref_size;
+    }
+    if (o->object_num >= ctx->check_memo_size)
+        return;
+
+    if (tracker->transparent)
+        memo |= CHECK_MEMO_TRANSPARENT;
+    if (tracker->has_overprint)
+        memo |= CHECK_MEMO_OVERPRINT;
+    ctx->check_memo[o->object_num] = memo;
+}
 
 static int
 pdfi_check_free_tracker(pdf_context *ctx, pdfi_check_tracker_t *tracker)
@@ -869,10 +940,16 @@ static int pdfi_check_Resources(pdf_context *ctx, pdf_dict *Resources_dict,
 {
     int code;
     pdf_obj *d = NULL;
+    bool memoise;
 
     if (resource_is_checked(tracker, (pdf_obj *)Resources_dict))
         return 0;
 
+    if (resource_is_memoised(ctx, tracker, (pdf_obj *)Resources_dict))
+        return 0;
+
+    memoise = tracker->spot_dict == NULL && !tracker->transparent && !tracker->has_overprint;
+
     /* First up, check any colour spaces, for new spot colours.
      * We only do this if asked because its expensive. spot_dict being NULL
      * means we aren't interested in spot colours (not a DeviceN or Separation device)
@@ -919,6 +996,9 @@ static int pdfi_check_Resources(pdf_context *ctx, pdf_dict *Resources_dict,
     pdfi_countdown(d);
     d = NULL;
 
+    if (memoise)
+        resource_memoise(ctx, tracker, (pdf_obj *)Resources_dict);
+
     return 0;
 }
 
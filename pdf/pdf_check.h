@@ -21,4 +21,6 @@ int pdfi_check_page(pdf_context *ctx, pdf_dict *page_dict, bool do_setup);
 int pdfi_check_Pattern_transparency(pdf_context *ctx, pdf_dict *pattern,
                                     pdf_dict *page_dict, bool *transparent);
 
+void pdfi_check_free_memo(pdf_context *ctx);
+
 #endif
@@ -1496,9 +1496,9 @@ pdfi_stream_to_buffer(pdf_context *ctx, pdf_stream *stream_obj, byte **buf, int6
 {
     byte *Buffer = NULL;
     int code = 0;
-    int64_t buflen = 0;
-    int bytes;
-    char c;
+    int64_t buflen = 0, bufsize;
+    int status;
+    uint nread;
     gs_offset_t savedoffset;
     pdf_c_stream *stream;
     bool filtered;
@@ -1528,31 +1528,58 @@ pdfi_stream_to_buffer(pdf_context *ctx, pdf_stream *stream_obj, byte **buf, int6
         if (code < 0) {
             goto exit;
         }
-        /* Find out how big it is */
+        /* Decode it in one pass, growing the buffer as we go. Start from a
+           guess based on the (encoded) Length, and trim the buffer afterwards.
+         */
+        bufsize = pdfi_stream_length(ctx, stream_obj);
+        bufsize = bufsize > 0x800000 ? 0x1000000 : bufsize * 2;
+        if (bufsize < 4096)
+            bufsize = 4096;
         do {
-            bytes = sfread(&c, 1, 1, stream->s);
-            if (bytes > 0)
-                buflen++;
-        } while (bytes >= 0);
+            if (buflen == bufsize) {
+                byte *NewBuffer;
+
+                bufsize *= 2;
+                NewBuffer = gs_resize_object(ctx->memory, Buffer, bufsize, "pdfi_stream_to_buffer (Buffer)");
+                if (NewBuffer == NULL) {
+                    code = gs_note_error(gs_error_VMerror);
+                    break;
+                }
+                Buffer = NewBuffer;
+            }
+            else if (Buffer == NULL) {
+                Buffer = gs_alloc_bytes(ctx->memory, bufsize, "pdfi_stream_to_buffer (Buffer)");
+                if (Buffer == NULL) {
+                    code = gs_note_error(gs_error_VMerror);
+                    break;
+                }
+            }
+            /* Any error or the end of the data ends the stream, as for a short read */
+            status = sgets(stream->s, Buffer + buflen, (uint)min(bufsize - buflen, max_uint), &nread);
+            buflen += nread;
+        } while (status >= 0 && nread > 0);
         pdfi_close_file(ctx, stream);
+        if (code < 0)
+            goto exit;
+        if (buflen > 0 && buflen < bufsize) {
+            byte *NewBuffer = gs_resize_object(ctx->memory, Buffer, buflen, "pdfi_stream_to_buffer (Buffer)");
+
+            /* If we can't shrink it, the bigger buffer will do */
+            if (NewBuffer != NULL)
+                Buffer = NewBuffer;
+        }
     } else {
         buflen = pdfi_stream_length(ctx, stream_obj);
-    }
 
-    /* Alloc buffer */
-    Buffer = gs_alloc_bytes(ctx->memory, buflen, "pdfi_stream_to_buffer (Buffer)");
-    if (!Buffer) {
-        code = gs_note_error(gs_error_VMerror);
-        goto exit;
-    }
-    code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, stream_obj), SEEK_SET);
-    if (code < 0)
-        goto exit;
-    if (filtered || ctx->encryption.is_encrypted) {
-        code = pdfi_filter(ctx, stream_obj, ctx->main_stream, &stream, false);
-        sfread(Buffer, 1, buflen, stream->s);
-        pdfi_close_file(ctx, stream);
-    } else {
+        /* Alloc buffer */
+        Buffer = gs_alloc_bytes(ctx->memory, buflen, "pdfi_stream_to_buffer (Buffer)");
+        if (!Buffer) {
+            code = gs_note_error(gs_error_VMerror);
+            goto exit;
+        }
+        code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, stream_obj), SEEK_SET);
+        if (code < 0)
+            goto exit;
         sfread(Buffer, 1, buflen, ctx->main_stream->s);
     }
 
@@ -17,6 +17,9 @@
 #include "strmio.h"
 #include "stream.h"
 #include "scanchar.h"
+#include "stat_.h"
+#include "gp.h"
+#include "gssprintf.h"
 
 #include "pdf_int.h"
 #include "pdf_types.h"
@@ -258,11 +261,285 @@ static int pdfi_font_scan_type_picker(byte *buf, int64_t buflen)
 #undef MAKEMAGIC
 }
 
-static int pdfi_add__to_native_fontmap(pdf_context *ctx, const char *fontname, const char *filepath, const int index)
+/* The native font scan index (-sPDFFontIndex=file) records, for every file
+   found in the font paths, its size and modification time and the fonts the
+   scan found in it. Files that have not changed since the index was written
+   are not opened again. The index is a text file:
+
+     %PDFFontIndex 1
+     F <size> <mtime> <path>
+     N <index> <fontname>     (one per font in the file, index -1 if not a TTC)
+
+   It is only an optimisation, so any problem reading or writing it just
+   means we scan the files.
+ */
+#define PDFI_FONTINDEX_HEADER "%PDFFontIndex 1\n"
+
+typedef struct pdfi_fontindex_rec_s
+{
+    const char *path;
+    int64_t size;
+    int64_t mtime;
+    char *names;        /* the record's "N" lines, or NULL */
+    bool used;
+} pdfi_fontindex_rec;
+
+typedef struct pdfi_fontindex_s
+{
+    byte *data;         /* the index file as read */
+    char *end;          /* the end of data */
+    pdfi_fontindex_rec *recs;
+    int nrecs;
+    bool changed;       /* the index needs to be written */
+    byte *out;          /* the index being written */
+    size_t outlen, outsize;
+    bool recording;     /* record the names of the file being scanned */
+} pdfi_fontindex;
+
+static int64_t
+pdfi_fontindex_number(char **pp)
+{
+    char *p = *pp;
+    int64_t v = 0;
+    bool neg = false;
+
+    if (*p == '-') {
+        neg = true;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9')
+        v = v * 10 + (*p++ - '0');
+    if (*p == ' ')
+        p++;
+    *pp = p;
+    return neg ? -v : v;
+}
+
+static int
+pdfi_fontindex_compare(const void *a, const void *b)
+{
+    return strcmp(((const pdfi_fontindex_rec *)a)->path,
+                  ((const pdfi_fontindex_rec *)b)->path);
+}
+
+/* Read and parse the index; on any problem, leave it empty */
+static void
+pdfi_fontindex_load(pdf_context *ctx, pdfi_fontindex *fi)
+{
+    gp_file *f;
+    gs_offset_t len = 0;
+    char *p, *end, *line, *nl;
+    int n;
+
+    fi->changed = true;
+    f = gp_fopen(ctx->memory, ctx->args.fontindex, "rb");
+    if (f == NULL)
+        return;
+    if (gp_fseek(f, 0, SEEK_END) == 0 && (len = gp_ftell(f)) > 0 &&
+        len < max_int && gp_fseek(f, 0, SEEK_SET) == 0) {
+        fi->data = gs_alloc_bytes(ctx->memory, len + 1, "pdfi_fontindex_load");
+        if (fi->data != NULL && gp_fread(fi->data, 1, len, f) != (size_t)len) {
+            gs_free_object(ctx->memory, fi->data, "pdfi_fontindex_load");
+            fi->data = NULL;
+        }
+    }
+    gp_fclose(f);
+    if (fi->data == NULL)
+        return;
+    p = (char *)fi->data;
+    end = p + len;
+    *end = '\0';
+    if (len < strlen(PDFI_FONTINDEX_HEADER) ||
+        memcmp(p, PDFI_FONTINDEX_HEADER, strlen(PDFI_FONTINDEX_HEADER)) != 0 ||
+        end[-1] != '\n')
+        goto bad;
+
+    for (n = 0, line = p; line < end; line++)
+        n += (*line == 'F' && line[-1] == '\n');
+    fi->recs = (pdfi_fontindex_rec *)gs_alloc_bytes(ctx->memory,
+                      (n + 1) * sizeof(pdfi_fontindex_rec), "pdfi_fontindex_load");
+    if (fi->recs == NULL)
+        goto bad;
+
+    fi->end = end;
+    for (line = p + strlen(PDFI_FONTINDEX_HEADER); line < end; line = nl + 1) {
+        /* Not strchr(), the file could contain a NUL */
+        nl = memchr(line, '\n', end - line);
+        if (nl == NULL)
+            goto bad;
+        if (line[0] == 'F' && line[1] == ' ') {
+            pdfi_fontindex_rec *r = &fi->recs[fi->nrecs++];
+
+            *nl = '\0';
+            line += 2;
+            r->size = pdfi_fontindex_number(&line);
+            r->mtime = pdfi_fontindex_number(&line);
+            r->path = line;
+            r->names = NULL;
+            r->used = false;
+        }
+        else if (line[0] == 'N' && line[1] == ' ' && fi->nrecs > 0) {
+            if (fi->recs[fi->nrecs - 1].names == NULL)
+                fi->recs[fi->nrecs - 1].names = line;
+        }
+        else
+            goto bad;
+    }
+    qsort(fi->recs, fi->nrecs, sizeof(pdfi_fontindex_rec), pdfi_fontindex_compare);
+    fi->changed = false;
+    return;
+
+  bad:
+    gs_free_object(ctx->memory, fi->recs, "pdfi_fontindex_load");
+    gs_free_object(ctx->memory, fi->data, "pdfi_fontindex_load");
+    fi->recs = NULL;
+    fi->nrecs = 0;
+    fi->data = NULL;
+    fi->end = NULL;
+}
+
+static pdfi_fontindex_rec *
+pdfi_fontindex_find(pdfi_fontindex *fi, const char *path)
+{
+    pdfi_fontindex_rec key;
+
+    if (fi->nrecs == 0)
+        return NULL;
+    key.path = path;
+    return (pdfi_fontindex_rec *)bsearch(&key, fi->recs, fi->nrecs,
+                  sizeof(pdfi_fontindex_rec), pdfi_fontindex_compare);
+}
+
+static int
+pdfi_fontindex_append(pdf_context *ctx, pdfi_fontindex *fi, const char *str, size_t len)
+{
+    if (fi->outlen + len > fi->outsize) {
+        size_t nsize = (fi->outsize == 0 ? 4096 : fi->outsize * 2);
+        byte *nout;
+
+        while (nsize < fi->outlen + len)
+            nsize *= 2;
+        nout = gs_alloc_bytes(ctx->memory, nsize, "pdfi_fontindex_append");
+        if (nout == NULL)
+            return_error(gs_error_VMerror);
+        if (fi->outlen > 0)
+            memcpy(nout, fi->out, fi->outlen);
+        gs_free_object(ctx->memory, fi->out, "pdfi_fontindex_append");
+        fi->out = nout;
+        fi->outsize = nsize;
+    }
+    memcpy(fi->out + fi->outlen, str, len);
+    fi->outlen += len;
+    return 0;
+}
+
+/* Start the record for a file; its names are appended by
+   pdfi_add__to_native_fontmap while the file is scanned. */
+static int
+pdfi_fontindex_add_file(pdf_context *ctx, pdfi_fontindex *fi, const char *path,
+                        const struct stat *st)
+{
+    char line[64];
+
+    fi->recording = false;
+    if (strchr(path, '\n') != NULL)
+        return 0;
+    gs_snprintf(line, sizeof(line), "F %"PRIi64" %"PRIi64" ",
+                (int64_t)st->st_size, (int64_t)st->st_mtime);
+    if (pdfi_fontindex_append(ctx, fi, line, strlen(line)) < 0 ||
+        pdfi_fontindex_append(ctx, fi, path, strlen(path)) < 0 ||
+        pdfi_fontindex_append(ctx, fi, "\n", 1) < 0)
+        return_error(gs_error_VMerror);
+    fi->recording = true;
+    return 0;
+}
+
+static int
+pdfi_fontindex_add_name(pdf_context *ctx, pdfi_fontindex *fi, const char *fontname, int index)
+{
+    char line[32];
+
+    if (!fi->recording || strchr(fontname, '\n') != NULL)
+        return 0;
+    gs_snprintf(line, sizeof(line), "N %d ", index);
+    if (pdfi_fontindex_append(ctx, fi, line, strlen(line)) < 0 ||
+        pdfi_fontindex_append(ctx, fi, fontname, strlen(fontname)) < 0 ||
+        pdfi_fontindex_append(ctx, fi, "\n", 1) < 0)
+        return_error(gs_error_VMerror);
+    return 0;
+}
+
+/* Write the new index next to the old one, and then replace it */
+static void
+pdfi_fontindex_write(pdf_context *ctx, pdfi_fontindex *fi)
+{
+    char prefix[gp_file_name_sizeof], tmpname[gp_file_name_sizeof];
+    gp_file *f;
+    bool ok;
+
+    if (strlen(ctx->args.fontindex) + 2 > sizeof(prefix))
+        return;
+    gs_snprintf(prefix, sizeof(prefix), "%s.", ctx->args.fontindex);
+    f = gp_open_scratch_file(ctx->memory, prefix, tmpname, "wb");
+    if (f == NULL)
+        return;
+    ok = gp_fwrite(PDFI_FONTINDEX_HEADER, 1, strlen(PDFI_FONTINDEX_HEADER), f) ==
+             strlen(PDFI_FONTINDEX_HEADER) &&
+         gp_fwrite(fi->out, 1, fi->outlen, f) == fi->outlen;
+    if (gp_fclose(f) != 0)
+        ok = false;
+    if (!ok || gp_rename(ctx->memory, tmpname, ctx->args.fontindex) != 0)
+        (void)gp_unlink(ctx->memory, tmpname);
+}
+
+static int pdfi_add__to_native_fontmap(pdf_context *ctx, const char *fontname, const char *filepath, const int index,
+                                       pdfi_fontindex *fi);
+
+/* Add the fonts an unchanged file had when it was indexed */
+static int
+pdfi_fontindex_replay(pdf_context *ctx, pdfi_fontindex *fi, pdfi_fontindex_rec *rec,
+                      const char *path, char *pname, int pname_size)
+{
+    char *line = rec->names, *nl;
+    int index, len, code;
+
+    while (line != NULL && line[0] == 'N') {
+        nl = memchr(line, '\n', fi->end - line);
+        if (nl == NULL)
+            break;
+        line += 2;
+        index = (int)pdfi_fontindex_number(&line);
+        len = nl - line > pname_size - 1 ? pname_size - 1 : nl - line;
+        memcpy(pname, line, len);
+        pname[len] = '\0';
+        code = pdfi_add__to_native_fontmap(ctx, pname, path, index, fi);
+        if (code < 0)
+            return code;
+        line = nl + 1;
+    }
+    return 0;
+}
+
+static void
+pdfi_fontindex_free(pdf_context *ctx, pdfi_fontindex *fi)
+{
+    gs_free_object(ctx->memory, fi->recs, "pdfi_fontindex_free");
+    gs_free_object(ctx->memory, fi->data, "pdfi_fontindex_free");
+    gs_free_object(ctx->memory, fi->out, "pdfi_fontindex_free");
+}
+
+static int pdfi_add__to_native_fontmap(pdf_context *ctx, const char *fontname, const char *filepath, const int index,
+                                       pdfi_fontindex *fi)
 {
     int code;
     pdf_string *fpstr;
 
+    if (fi != NULL) {
+        code = pdfi_fontindex_add_name(ctx, fi, fontname, index);
+        if (code < 0)
+            return code;
+    }
+
     if (ctx->pdfnativefontmap == NULL) {
         /* 32 is just an arbitrary starting point */
         code = pdfi_dict_alloc(ctx, 32, &ctx->pdfnativefontmap);
@@ -330,7 +607,8 @@ pdfi_end_ps_token(int c)
 }
 
 /* Naive way to find a Type 1 /FontName key */
-static int pdfi_type1_add_to_native_map(pdf_context *ctx, stream *f, char *fname, char *pname, int pname_size)
+static int pdfi_type1_add_to_native_map(pdf_context *ctx, stream *f, char *fname, char *pname, int pname_size,
+                                        pdfi_fontindex *fi)
 {
     gs_string buf;
     uint count = 0;
@@ -392,7 +670,7 @@ static int pdfi_type1_add_to_native_map(pdf_context *ctx, stream *f, char *fname
         count = 0;
     }
     if (type == 1 && namestr != NULL) {
-        code = pdfi_add__to_native_fontmap(ctx, (const char *)pname, (const char *)fname, -1);
+        code = pdfi_add__to_native_fontmap(ctx, (const char *)pname, (const char *)fname, -1, fi);
     }
     return code < 0 ? code : gs_error_handled;
 }
@@ -432,7 +710,8 @@ sru32(stream *s)
     return u32(p);
 }
 
-static int pdfi_ttf_add_to_native_map(pdf_context *ctx, stream *f, byte magic[4], char *fname, char *pname, int pname_size)
+static int pdfi_ttf_add_to_native_map(pdf_context *ctx, stream *f, byte magic[4], char *fname, char *pname, int pname_size,
+                                      pdfi_fontindex *fi)
 {
     int ntables, i, j, k, code2, code = gs_error_undefined;
     char table[4];
@@ -581,7 +860,7 @@ static int pdfi_ttf_add_to_native_map(pdf_context *ctx, stream *f, byte magic[4]
             }
         }
         if (code >= 0)
-            code = pdfi_add__to_native_fontmap(ctx, (const char *)pname, (const char *)fname, (include_index == true ? findex : -1));
+            code = pdfi_add__to_native_fontmap(ctx, (const char *)pname, (const char *)fname, (include_index == true ? findex : -1), fi);
     }
     return code;
 }
@@ -636,6 +915,9 @@ static int pdfi_generate_native_fontmap(pdf_context *ctx)
     stream *sf;
     int code = 0, l;
     uint nread;
+    pdfi_fontindex fi, *pfi = NULL;
+    pdfi_fontindex_rec *rec;
+    struct stat st;
 
     if (ctx->pdfnativefontmap != NULL) /* Only run this once */
         return 0;
@@ -650,6 +932,12 @@ static int pdfi_generate_native_fontmap(pdf_context *ctx)
         return_error(gs_error_VMerror);
     }
 
+    if (ctx->args.fontindex != NULL && ctx->search_paths.num_font_paths > 0) {
+        memset(&fi, 0x00, sizeof(fi));
+        pdfi_fontindex_load(ctx, &fi);
+        pfi = &fi;
+    }
+
     for (i = 0; i < ctx->search_paths.num_font_paths; i++) {
 
         memcpy(patrn, ctx->search_paths.font_paths[i].data, ctx->search_paths.font_paths[i].size);
@@ -664,7 +952,31 @@ static int pdfi_generate_native_fontmap(pdf_context *ctx)
             if (font_scan_skip_file(result))
                 continue;
 
+            if (pfi != NULL) {
+                pfi->recording = false;
+                if (gp_stat(ctx->memory, result, &st) >= 0) {
+                    rec = pdfi_fontindex_find(pfi, result);
+                    if (rec != NULL && !rec->used && rec->size == (int64_t)st.st_size &&
+                        rec->mtime == (int64_t)st.st_mtime) {
+                        rec->used = true;
+                        code = pdfi_fontindex_add_file(ctx, pfi, result, &st);
+                        if (code >= 0)
+                            code = pdfi_fontindex_replay(ctx, pfi, rec, result, working, gp_file_name_sizeof);
+                        if (code == gs_error_VMerror)
+                            break;
+                        code = 0;
+                        continue;
+                    }
+                    pfi->changed = true;
+                    code = pdfi_fontindex_add_file(ctx, pfi, result, &st);
+                    if (code < 0)
+                        break;
+                }
+            }
+
             sf = sfopen(result, "r", ctx->memory);
+            if (sf == NULL)
+                continue;
             code = sgets(sf, magic, 4, &nread);
             if (code < 0 || nread < 4) {
                 sfclose(sf);
@@ -688,14 +1000,14 @@ static int pdfi_generate_native_fontmap(pdf_context *ctx)
             }
             switch(type) {
                 case tt_font:
-                  code = pdfi_ttf_add_to_native_map(ctx, sf, magic, result, working, gp_file_name_sizeof);
+                  code = pdfi_ttf_add_to_native_map(ctx, sf, magic, result, working, gp_file_name_sizeof, pfi);
                   break;
                 case cff_font:
                       code = gs_error_undefined;
                   break;
                 case type1_font:
                 default:
-                  code = pdfi_type1_add_to_native_map(ctx, sf, result, working, gp_file_name_sizeof);
+                  code = pdfi_type1_add_to_native_map(ctx, sf, result, working, gp_file_name_sizeof, pfi);
                   break;
             }
             sfclose(sf);
@@ -709,6 +1021,16 @@ static int pdfi_generate_native_fontmap(pdf_context *ctx)
             gp_enumerate_files_close(ctx->memory, fe);
     }
 
+    if (pfi != NULL) {
+        /* Files that have gone away also mean the index is out of date */
+        for (i = 0; i < pfi->nrecs; i++)
+            if (!pfi->recs[i].used)
+                pfi->changed = true;
+        if (pfi->changed && code >= 0)
+            pdfi_fontindex_write(ctx, pfi);
+        pdfi_fontindex_free(ctx, pfi);
+    }
+
 #if 0
     if (ctx->pdfnativefontmap != NULL) {
         uint64_t ind;
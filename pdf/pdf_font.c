@@ -37,6 +37,7 @@
 #include "strmio.h"
 #include "stream.h"
 #include "gsstate.h"            /* For gs_setPDFfontsize() */
+#include "gsmd5.h"              /* For the font file cache */
 
 static int pdfi_gs_setfont(pdf_context *ctx, gs_font *pfont)
 {
@@ -572,6 +573,186 @@ pdfi_open_font_substitute_file(pdf_context *ctx, pdf_dict *font_dict, pdf_dict *
     return code;
 }
 
+/* Byte-identical embedded font files (the same subset embedded under many
+   font objects, as happens in merged documents) are only decoded once. The
+   decoded data is kept, up to PDFI_FONTFILE_CACHE_MAX bytes in all, keyed by
+   an MD5 digest of the raw stream data. The same digest gives TrueType fonts
+   an XUID, so that identical fonts share the glyph cache too.
+ */
+#define PDFI_FONTFILE_CACHE_MAX (16 * 1024 * 1024)
+
+typedef struct pdfi_fontfile_entry_s
+{
+    struct pdfi_fontfile_entry_s *next;
+    gs_md5_byte_t digest[16];
+    byte *data;
+    int64_t length;
+} pdfi_fontfile_entry;
+
+/* Only streams whose decoded data depends on nothing but their bytes are
+   keyed: unencrypted, and either unfiltered or plain FlateDecode.
+   Returns true if we made a digest.
+ */
+static bool
+pdfi_fontfile_digest(pdf_context *ctx, pdf_stream *fontfile, gs_md5_byte_t digest[16])
+{
+    pdf_dict *stream_dict = NULL;
+    pdf_obj *filter = NULL;
+    pdf_name *name = NULL;
+    bool known, ok = false;
+    gs_md5_state_t md5;
+    byte buf[4096];
+    int64_t length;
+    gs_offset_t savedoffset;
+    int code;
+    uint nread;
+
+    if (ctx->encryption.is_encrypted)
+        return false;
+    if (pdfi_dict_from_obj(ctx, (pdf_obj *)fontfile, &stream_dict) < 0)
+        return false;
+    if (pdfi_dict_known(ctx, stream_dict, "F", &known) < 0 || known)
+        return false;
+    if (pdfi_dict_known(ctx, stream_dict, "DecodeParms", &known) < 0 || known)
+        return false;
+    code = pdfi_dict_knownget(ctx, stream_dict, "Filter", &filter);
+    if (code < 0)
+        return false;
+    if (code > 0) {
+        if (filter->type == PDF_ARRAY && pdfi_array_size((pdf_array *)filter) == 1)
+            (void)pdfi_array_get_type(ctx, (pdf_array *)filter, 0, PDF_NAME, (pdf_obj **)&name);
+        else if (filter->type == PDF_NAME) {
+            name = (pdf_name *)filter;
+            pdfi_countup(name);
+        }
+        known = name != NULL && (pdfi_name_is(name, "FlateDecode") || pdfi_name_is(name, "Fl"));
+        pdfi_countdown(name);
+        pdfi_countdown(filter);
+        if (!known)
+            return false;
+    }
+    length = pdfi_stream_length(ctx, fontfile);
+    if (length <= 0)
+        return false;
+
+    gs_md5_init(&md5);
+    gs_md5_append(&md5, (const gs_md5_byte_t *)(code > 0 ? "Flate" : "None"), 4);
+    savedoffset = pdfi_tell(ctx->main_stream);
+    if (pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, fontfile), SEEK_SET) >= 0) {
+        do {
+            code = sgets(ctx->main_stream->s, buf, (uint)min(length, sizeof(buf)), &nread);
+            gs_md5_append(&md5, buf, nread);
+            length -= nread;
+        } while (length > 0 && code >= 0 && nread > 0);
+        ok = (length == 0);
+    }
+    pdfi_seek(ctx, ctx->main_stream, savedoffset, SEEK_SET);
+    gs_md5_finish(&md5, digest);
+    return ok;
+}
+
+/* Like pdfi_stream_to_buffer, but from the cache if we can */
+static int
+pdfi_fontfile_to_buffer(pdf_context *ctx, pdf_stream *fontfile, byte **buf, int64_t *buflen,
+                        gs_md5_byte_t digest[16], bool *has_digest)
+{
+    pdfi_fontfile_entry *e, **pe;
+    int code;
+
+    *has_digest = pdfi_fontfile_digest(ctx, fontfile, digest);
+    if (*has_digest) {
+        for (pe = &ctx->fontfile_cache; (e = *pe) != NULL; pe = &e->next) {
+            if (memcmp(e->digest, digest, sizeof(e->digest)) == 0) {
+                *buf = gs_alloc_bytes(ctx->memory, e->length, "pdfi_load_font(fbuf)");
+                if (*buf == NULL)
+                    return_error(gs_error_VMerror);
+                memcpy(*buf, e->data, e->length);
+                *buflen = e->length;
+                /* Most recently used first */
+                *pe = e->next;
+                e->next = ctx->fontfile_cache;
+                ctx->fontfile_cache = e;
+                return 0;
+            }
+        }
+    }
+
+    code = pdfi_stream_to_buffer(ctx, fontfile, buf, buflen);
+    if (code < 0 || !*has_digest || *buflen <= 0 || *buflen > PDFI_FONTFILE_CACHE_MAX / 4)
+        return code;
+
+    /* A failure to cache the data isn't an error */
+    e = (pdfi_fontfile_entry *)gs_alloc_bytes(ctx->memory, sizeof(pdfi_fontfile_entry), "pdfi_fontfile_to_buffer");
+    if (e == NULL)
+        return 0;
+    e->data = gs_alloc_bytes(ctx->memory, *buflen, "pdfi_fontfile_to_buffer(data)");
+    if (e->data == NULL) {
+        gs_free_object(ctx->memory, e, "pdfi_fontfile_to_buffer");
+        return 0;
+    }
+    memcpy(e->digest, digest, sizeof(e->digest));
+    memcpy(e->data, *buf, *buflen);
+    e->length = *buflen;
+    e->next = ctx->fontfile_cache;
+    ctx->fontfile_cache = e;
+    ctx->fontfile_cache_size += e->length;
+
+    /* Drop the least recently used entries until we are within the limit */
+    pe = &ctx->fontfile_cache;
+    while (ctx->fontfile_cache_size > PDFI_FONTFILE_CACHE_MAX && (*pe)->next != NULL) {
+        while ((*pe)->next != NULL)
+            pe = &(*pe)->next;
+        e = *pe;
+        *pe = NULL;
+        ctx->fontfile_cache_size -= e->length;
+        gs_free_object(ctx->memory, e->data, "pdfi_fontfile_to_buffer(data)");
+        gs_free_object(ctx->memory, e, "pdfi_fontfile_to_buffer");
+        pe = &ctx->fontfile_cache;
+    }
+    return 0;
+}
+
+void pdfi_free_fontfile_cache(pdf_context *ctx)
+{
+    pdfi_fontfile_entry *e = ctx->fontfile_cache, *next;
+
+    while (e != NULL) {
+        next = e->next;
+        gs_free_object(ctx->memory, e->data, "pdfi_free_fontfile_cache(data)");
+        gs_free_object(ctx->memory, e, "pdfi_free_fontfile_cache");
+        e = next;
+    }
+    ctx->fontfile_cache = NULL;
+    ctx->fontfile_cache_size = 0;
+}
+
+/* Replace the font's UniqueID with an XUID made from the font file digest.
+   'key' is anything outside the font file which changes how glyphs map to
+   outlines. As with pdfi_font_generate_pseudo_XUID, if we can't allocate the
+   XUID values we just keep the existing UID.
+ */
+static void
+pdfi_font_set_content_XUID(gs_font_base *pfont, const gs_md5_byte_t digest[16], int key)
+{
+    long *xvalues;
+    int i;
+
+    xvalues = (long *)gs_alloc_bytes(pfont->memory, 7 * sizeof(long), "pdfi_font_set_content_XUID");
+    if (xvalues == NULL)
+        return;
+    xvalues[0] = 1000000; /* "Private" value */
+    xvalues[1] = 1;       /* tells these apart from the pseudo XUIDs */
+    xvalues[2] = key;
+    /* pdfwrite only compares the last value, so the digest goes at the end */
+    for (i = 0; i < 4; i++)
+        xvalues[i + 3] = (long)(((uint32_t)digest[i * 4] << 24 | (uint32_t)digest[i * 4 + 1] << 16 |
+                                 (uint32_t)digest[i * 4 + 2] << 8 | (uint32_t)digest[i * 4 + 3]) & 0x7fffffff);
+
+    if (uid_is_XUID(&pfont->UID))
+        uid_free(&pfont->UID, pfont->memory, "pdfi_font_set_content_XUID");
+    uid_set_XUID(&pfont->UID, xvalues, 7);
+}
+
 enum {
   font_embedded = 0,
   font_from_file = 1,
@@ -592,6 +773,8 @@ int pdfi_load_font(pdf_context *ctx, pdf_dict *stream_dict, pdf_dict *page_dict,
     int64_t fbuflen;
     int substitute = font_embedded;
     int findex = -1;
+    gs_md5_byte_t digest[16];
+    bool has_digest = false;
 
     code = pdfi_dict_get_type(ctx, font_dict, "Type", PDF_NAME, (pdf_obj **)&Type);
     if (code < 0)
@@ -647,7 +830,7 @@ int pdfi_load_font(pdf_context *ctx, pdf_dict *stream_dict, pdf_dict *page_dict,
         }
 
         if (fontfile != NULL) {
-            code = pdfi_stream_to_buffer(ctx, (pdf_stream *) fontfile, &fbuf, &fbuflen);
+            code = pdfi_fontfile_to_buffer(ctx, (pdf_stream *) fontfile, &fbuf, &fbuflen, digest, &has_digest);
             pdfi_countdown(fontfile);
             if (fbuflen == 0) {
                 gs_free_object(ctx->memory, fbuf, "pdfi_load_font(fbuf)");
@@ -746,6 +929,14 @@ int pdfi_load_font(pdf_context *ctx, pdf_dict *stream_dict, pdf_dict *page_dict,
         else {
             if ((substitute & font_substitute) == font_substitute)
                 code = pdfi_font_match_glyph_widths(ppdffont);
+            /* TrueType glyphs map to outlines through the font's own cmap
+               tables, and which tables are used depends only on the symbolic
+               flag, so identical fonts with the same flag can share cached glyphs.
+             */
+            else if (substitute == font_embedded && has_digest
+                  && ppdffont->pdfi_font_type == e_pdf_font_truetype)
+                pdfi_font_set_content_XUID(ppdffont->pfont, digest,
+                                           (int)(((pdf_font_truetype *)ppdffont)->descflags & 4));
         }
         *ppfont = (gs_font *)ppdffont->pfont;
      }
@@ -103,4 +103,5 @@ enum {
 
 int pdfi_get_cidfont_glyph_metrics(gs_font *pfont, gs_glyph cid, double *widths, bool vertical);
 int pdfi_font_generate_pseudo_XUID(pdf_context *ctx, pdf_dict *fontdict, gs_font_base *pfont);
+void pdfi_free_fontfile_cache(pdf_context *ctx);
 #endif
@@ -39,6 +39,12 @@
 #include "gsform1.h"
 #include "gstrans.h"
 #include "gxdevsop.h"               /* For special ops */
+#include "sdct.h"           /* For the DCTDecode stream state */
+#ifdef USE_OPENJPEG_JP2
+#  include "sjpx_openjpeg.h"    /* For the JPXDecode stream state */
+#endif
+#include "gxpath.h"         /* For gx_effective_clip_path() */
+#include "sisparam.h"       /* For MAX_ISCALE_SUPPORT */
 #include "gspath.h"         /* For gs_moveto() and friends */
 #include "gsstate.h"        /* For gs_setoverprintmode() */
 #include "gscoord.h"        /* for gs_concat() and others */
@@ -692,10 +698,14 @@ error_inline_check:
 /* Render a PDF image
  * pim can be type1 (or imagemask), type3, type4
  */
+/* Only the first rows of the image data are read; if that is less than the
+ * image height, the rest is known to be outside the clip and the image is
+ * ended early, leaving it unread.
+ */
 static int
 pdfi_render_image(pdf_context *ctx, gs_pixel_image_t *pim, pdf_c_stream *image_stream,
                   unsigned char *mask_buffer, uint64_t mask_size,
-                  int comps, bool ImageMask)
+                  int comps, bool ImageMask, int rows)
 {
     int code;
     gs_image_enum *penum = NULL;
@@ -767,6 +777,8 @@ pdfi_render_image(pdf_context *ctx, gs_pixel_image_t *pim, pdf_c_stream *image_s
      */
     linelen = pdfi_get_image_line_size((gs_data_image_t *)pim, comps);
     bytes_left = pdfi_get_image_data_size((gs_data_image_t *)pim, comps);
+    if (rows < pim->Height)
+        bytes_left = linelen * rows;
     buffer = gs_alloc_bytes(ctx->memory, linelen, "pdfi_render_image (buffer)");
     if (!buffer) {
         code = gs_note_error(gs_error_VMerror);
@@ -1432,6 +1444,202 @@ pdfi_image_get_color(pdf_context *ctx, pdf_c_stream *source, pdfi_image_info_t *
     return code;
 }
 
+/* Find the size of an image sample in device pixels, along each of the
+ * image axes.
+ */
+static int
+pdfi_image_sample_size(pdf_context *ctx, gs_pixel_image_t *pim, double *s1, double *s2)
+{
+    gs_matrix inverseIM;
+    gs_point pt, pt1;
+    int code;
+
+    code = gs_matrix_invert(&pim->ImageMatrix, &inverseIM);
+    if (code < 0)
+        return code;
+    code = gs_distance_transform(0, 1, &inverseIM, &pt);
+    if (code < 0)
+        return code;
+    code = gs_distance_transform(pt.x, pt.y, &ctm_only(ctx->pgs), &pt1);
+    if (code < 0)
+        return code;
+    *s1 = sqrt(pt1.x * pt1.x + pt1.y * pt1.y);
+    code = gs_distance_transform(1, 0, &inverseIM, &pt);
+    if (code < 0)
+        return code;
+    code = gs_distance_transform(pt.x, pt.y, &ctm_only(ctx->pgs), &pt1);
+    if (code < 0)
+        return code;
+    *s2 = sqrt(pt1.x * pt1.x + pt1.y * pt1.y);
+    return 0;
+}
+
+/* If the image data is a JPEG which will be drawn at half its size or
+ * less in both directions, ask the decoder for a 1/2, 1/4 or 1/8 size image
+ * instead (libjpeg does this very cheaply in the IDCT), and adjust the
+ * image to match. We only go as far as still leaving one sample per device
+ * pixel, so the only detail lost is what rendering would discard anyway.
+ */
+static int
+pdfi_image_reduce_DCT(pdf_context *ctx, gs_pixel_image_t *pim, pdf_c_stream *image_stream)
+{
+    stream *s = image_stream->s;
+    stream_DCT_state *ss;
+    double s1, s2;
+    int code, factor;
+
+    if (s == NULL || s->state == NULL || s->state->templat == NULL ||
+        s->state->templat->process != s_DCTD_template.process)
+        return 0;
+    ss = (stream_DCT_state *)s->state;
+    if (ss->phase != 0 || ss->data.decompress->PassThrough)
+        return 0;
+
+    code = pdfi_image_sample_size(ctx, pim, &s1, &s2);
+    if (code < 0)
+        return code;
+
+    factor = 1;
+    while (factor < 8 && s1 * factor * 2 <= 1.0 && s2 * factor * 2 <= 1.0)
+        factor *= 2;
+    if (factor == 1)
+        return 0;
+
+    ss->data.decompress->ScaleDenom = factor;
+    /* Same rounding as libjpeg uses for the output dimensions */
+    pim->Width = (pim->Width + factor - 1) / factor;
+    pim->Height = (pim->Height + factor - 1) / factor;
+    pim->ImageMatrix.xx = (float)pim->Width;
+    pim->ImageMatrix.yy = (float)(pim->Height * -1);
+    pim->ImageMatrix.ty = (float)pim->Height;
+    return 0;
+}
+
+/* Find the part of the image that can be seen through the clip, in image
+ * samples, grown by margin samples on each side and limited to the image.
+ * If scaler_margin is true, the margin also covers the samples the
+ * interpolating scaler reads around the visible ones, as allowed for by
+ * the decode rectangle in gx_image_enum_begin().
+ * Returns 1 if the area is known (it may be empty), 0 if it could not be
+ * worked out and the whole image has to be assumed visible.
+ */
+static int
+pdfi_image_visible_area(pdf_context *ctx, gs_pixel_image_t *pim, int margin,
+                        bool scaler_margin, gs_int_rect *area)
+{
+    gx_clip_path *pcpath;
+    gs_fixed_rect fbox;
+    gs_rect dbox, ibox;
+    gs_matrix inverseIM, mat;
+    int code;
+
+    code = gx_effective_clip_path(ctx->pgs, &pcpath);
+    if (code < 0)
+        return code;
+    gx_cpath_outer_box(pcpath, &fbox);
+    dbox.p.x = fixed2float(fbox.p.x);
+    dbox.p.y = fixed2float(fbox.p.y);
+    dbox.q.x = fixed2float(fbox.q.x);
+    dbox.q.y = fixed2float(fbox.q.y);
+    code = gs_matrix_invert(&pim->ImageMatrix, &inverseIM);
+    if (code < 0)
+        return code;
+    code = gs_matrix_multiply(&inverseIM, &ctm_only(ctx->pgs), &mat);
+    if (code < 0)
+        return code;
+    code = gs_bbox_transform_inverse(&dbox, &mat, &ibox);
+    if (code < 0 || ibox.p.x <= -1e6 || ibox.q.x >= 1e6 || ibox.p.y <= -1e6 || ibox.q.y >= 1e6)
+        return 0;
+    if (scaler_margin) {
+        double support;
+
+        code = gs_matrix_invert(&mat, &inverseIM);
+        if (code < 0)
+            return 0;
+        support = max(max(fabs(inverseIM.xx), fabs(inverseIM.yy)),
+                      max(fabs(inverseIM.xy), fabs(inverseIM.yx)));
+        margin += (int)(MAX_ISCALE_SUPPORT * (support + 1)) + 2;
+    }
+    area->p.x = max((int)floor(ibox.p.x) - margin, 0);
+    area->p.y = max((int)floor(ibox.p.y) - margin, 0);
+    area->q.x = min((int)ceil(ibox.q.x) + margin, (int)pim->Width);
+    area->q.y = min((int)ceil(ibox.q.y) + margin, (int)pim->Height);
+    return 1;
+}
+
+#ifdef USE_OPENJPEG_JP2
+/* The JPEG 2000 equivalent: discard resolution levels while a sample still
+ * covers no more than a device pixel, and if the clip shows only part of
+ * the image, have OpenJPEG decode just the code blocks for that area.
+ */
+static int
+pdfi_image_reduce_JPX(pdf_context *ctx, gs_pixel_image_t *pim, pdf_c_stream *image_stream)
+{
+    stream *s = image_stream->s;
+    stream_jpxd_state *ss;
+    gs_int_rect area;
+    double s1, s2;
+    int code, factor = 1, reduce = 0;
+    int x0 = 0, y0 = 0, x1 = pim->Width, y1 = pim->Height;
+    bool has_area = false;
+
+    if (s == NULL || s->state == NULL || s->state->templat == NULL ||
+        s->state->templat->process != s_jpxd_template.process)
+        return 0;
+    ss = (stream_jpxd_state *)s->state;
+    if (ss->image != NULL || ss->PassThrough)
+        return 0;
+
+    code = pdfi_image_sample_size(ctx, pim, &s1, &s2);
+    if (code < 0)
+        return code;
+    while (reduce < 5 && s1 * factor * 2 <= 1.0 && s2 * factor * 2 <= 1.0) {
+        factor *= 2;
+        reduce++;
+    }
+
+    /* The part of the image inside the clip, with a margin for
+     * interpolation, rounded out to whole reduced samples.
+     */
+    code = pdfi_image_visible_area(ctx, pim, 2 * factor, false, &area);
+    if (code < 0)
+        return code;
+    if (code > 0) {
+        area.p.x = area.p.x / factor * factor;
+        area.p.y = area.p.y / factor * factor;
+        /* Nothing visible, or most of it visible: decode it all */
+        if (area.q.x > area.p.x && area.q.y > area.p.y &&
+            (double)(area.q.x - area.p.x) * (area.q.y - area.p.y) < 0.75 * pim->Width * pim->Height) {
+            x0 = area.p.x, y0 = area.p.y, x1 = area.q.x, y1 = area.q.y;
+            has_area = true;
+        }
+    }
+    if (reduce == 0 && !has_area)
+        return 0;
+
+    ss->reduce = reduce;
+    ss->has_area = has_area;
+    ss->area_x0 = x0;
+    ss->area_y0 = y0;
+    ss->area_x1 = x1;
+    ss->area_y1 = y1;
+    /* x0 and y0 are multiples of factor, so this is OpenJPEG's rounding */
+    pim->Width = (x1 + factor - 1) / factor - x0 / factor;
+    pim->Height = (y1 + factor - 1) / factor - y0 / factor;
+    ss->out_width = pim->Width;
+    ss->out_height = pim->Height;
+
+    /* Image space moves to the origin of the area, then shrinks */
+    pim->ImageMatrix.xx /= factor;
+    pim->ImageMatrix.xy /= factor;
+    pim->ImageMatrix.yx /= factor;
+    pim->ImageMatrix.yy /= factor;
+    pim->ImageMatrix.tx = (pim->ImageMatrix.tx - x0) / factor;
+    pim->ImageMatrix.ty = (pim->ImageMatrix.ty - y0) / factor;
+    return 0;
+}
+#endif
+
 /* Make a fake SMask dict from a JPX SMaskInData */
 static int
 pdfi_make_smask_dict(pdf_context *ctx, pdf_stream *image_stream, pdfi_image_info_t *image_info,
@@ -1543,7 +1751,7 @@ pdfi_do_image(pdf_context *ctx, pdf_dict *page_dict, pdf_dict *stream_dict, pdf_
 {
     pdf_c_stream *new_stream = NULL;
     int code = 0, code1 = 0;
-    int comps = 0;
+    int comps = 0, rows;
     gs_color_space  *pcs = NULL;
     gs_image1_t t1image;
     gs_image4_t t4image;
@@ -1911,6 +2119,21 @@ pdfi_do_image(pdf_context *ctx, pdf_dict *page_dict, pdf_dict *stream_dict, pdf_
     if (code < 0)
         goto cleanupExit;
 
+    if (ctx->args.reducejpeg && pim == (gs_pixel_image_t *)&t1image &&
+        !image_info.ImageMask && image_info.BPC == 8 && !ctx->device_state.HighLevelDevice) {
+        code = pdfi_image_reduce_DCT(ctx, pim, new_stream);
+        if (code < 0)
+            goto cleanupExit;
+    }
+#ifdef USE_OPENJPEG_JP2
+    if (ctx->args.reducejpeg && pim == (gs_pixel_image_t *)&t1image &&
+        image_info.is_JPXDecode && !ctx->device_state.HighLevelDevice) {
+        code = pdfi_image_reduce_JPX(ctx, pim, new_stream);
+        if (code < 0)
+            goto cleanupExit;
+    }
+#endif
+
     /* This duplicates the code in gs_img.ps; if we have an imagemask, with 1 bit per component (is there any other kind ?)
      * and the image is to be interpolated, and we are nto sending it to a high level device. Then check the scaling.
      * If we are scaling up (in device space) by afactor of more than 2, then we install the ImScaleDecode filter,
@@ -1965,6 +2188,23 @@ pdfi_do_image(pdf_context *ctx, pdf_dict *page_dict, pdf_dict *stream_dict, pdf_
         }
     }
 
+    /* If the clip cuts off the bottom of the image (in image space), there
+     * is no need to decompress the rows below it. The gx image code already
+     * skips rows, and converts only the columns, that the clip can reach.
+     * Inline image data has to be read to find the end of it, and high level
+     * devices want the whole image.
+     */
+    rows = pim->Height;
+    if (!inline_image && mask_buffer == NULL && !ctx->device_state.HighLevelDevice) {
+        gs_int_rect area;
+
+        code = pdfi_image_visible_area(ctx, pim, 1, true, &area);
+        if (code < 0)
+            goto cleanupExit;
+        if (code > 0)
+            rows = max(area.q.y, 0);
+    }
+
     code = pdfi_image_setup_trans(ctx, &trans_state);
     if (code < 0)
         goto cleanupExit;
@@ -1972,7 +2212,7 @@ pdfi_do_image(pdf_context *ctx, pdf_dict *page_dict, pdf_dict *stream_dict, pdf_
     /* Render the image */
     code = pdfi_render_image(ctx, pim, new_stream,
                              mask_buffer, mask_size,
-                             comps, image_info.ImageMask);
+                             comps, image_info.ImageMask, rows);
     if (code < 0) {
         if (ctx->args.pdfdebug)
             dmprintf1(ctx->memory, "WARNING: pdfi_do_image: error %d from pdfi_render_image\n", code);
@@ -49,41 +49,87 @@
 
 /***********************************************************************************/
 /* Some simple functions to find white space, delimiters and hex bytes             */
-static bool iswhite(char c)
+/* These are used for every byte we tokenise, so rather than a chain of comparisons */
+/* we classify each byte with a single table lookup.                                */
+#define PDFI_CHAR_WHITE     0x01
+#define PDFI_CHAR_DELIMITER 0x02
+#define PDFI_CHAR_DIGIT     0x04
+#define PDFI_CHAR_HEX       0x08
+
+#define W PDFI_CHAR_WHITE
+#define D PDFI_CHAR_DELIMITER
+#define N PDFI_CHAR_DIGIT
+#define H PDFI_CHAR_HEX
+
+static const byte pdfi_char_class[256] = {
+    W, 0, 0, 0, 0, 0, 0, 0, 0, W, W, 0, W, W, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    W, 0, 0, 0, 0, D, 0, 0, D, D, 0, 0, 0, 0, 0, D,
+    N|H, N|H, N|H, N|H, N|H, N|H, N|H, N|H, N|H, N|H, 0, 0, D, 0, D, 0,
+    0, H, H, H, H, H, H, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D, 0, D, 0, 0,
+    0, H, H, H, H, H, H, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D, 0, D, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#undef W
+#undef D
+#undef N
+#undef H
+
+static inline bool iswhite(char c)
 {
-    if (c == 0x00 || c == 0x09 || c == 0x0a || c == 0x0c || c == 0x0d || c == 0x20)
-        return true;
-    else
-        return false;
+    return (pdfi_char_class[(byte)c] & PDFI_CHAR_WHITE) != 0;
 }
 
-static bool isdelimiter(char c)
+static inline bool isdelimiter(char c)
 {
-    if (c == '/' || c == '(' || c == ')' || c == '[' || c == ']' || c == '<' || c == '>' || c == '{' || c == '}' || c == '%')
-        return true;
-    else
-        return false;
+    return (pdfi_char_class[(byte)c] & PDFI_CHAR_DELIMITER) != 0;
 }
 
-static bool ishex(char c)
+static inline bool ishex(char c)
 {
-    if (c < 0x30)
-        return false;
+    return (pdfi_char_class[(byte)c] & PDFI_CHAR_HEX) != 0;
+}
 
-    if (c > 0x39) {
-        if (c > 'F') {
-            if (c < 'a')
-                return false;
-            if (c > 'f')
-                return false;
-            return true;
-        } else {
-            if (c < 'A')
-                return false;
-            return true;
-        }
-    } else
-        return true;
+/* True for bytes which can be part of a 'regular' token (number, name or keyword) */
+static inline bool isregular(byte c)
+{
+    return (pdfi_char_class[c] & (PDFI_CHAR_WHITE | PDFI_CHAR_DELIMITER)) == 0;
+}
+
+/* Most of the time the bytes we want are already sitting in the buffer of the
+ * underlying stream, and nothing has been 'unread'. In that case the tokeniser
+ * can scan a whole token in place rather than pulling it through
+ * pdfi_read_bytes() one byte at a time. pdfi_buffered_bytes() returns the number
+ * of bytes we can look at directly, which is 0 whenever that's not possible.
+ */
+static inline uint pdfi_buffered_bytes(pdf_c_stream *s, const byte **p)
+{
+    *p = NULL;
+    if (s->unread_size != 0 || s->eof || s->s == NULL)
+        return 0;
+    *p = sbufptr(s->s);
+    return sbufavailable(s->s);
+}
+
+static inline void pdfi_skip_buffered(pdf_c_stream *s, uint count)
+{
+    (void)sbufskip(s->s, count);
+}
+
+/* Put back a single byte taken with pdfi_skip_buffered(), it is still in the buffer */
+static inline void pdfi_unskip_buffered(pdf_c_stream *s)
+{
+    s->s->cursor.r.ptr--;
 }
 
 /* You must ensure the character is a hex character before calling this, no error trapping here */
@@ -109,6 +155,26 @@ int pdfi_skip_white(pdf_context *ctx, pdf_c_stream *s)
     uint32_t read = 0;
     int32_t bytes = 0;
     byte c;
+    const byte *p;
+    uint avail, n;
+
+    /* Skip as much as we can in the stream buffer, then fall back to reading bytes */
+    while ((avail = pdfi_buffered_bytes(s, &p)) > 0) {
+        for (n = 0; n < avail && iswhite(p[n]); n++);
+        pdfi_skip_buffered(s, n);
+        if (n < avail)
+            return 0;
+        /* Used up the buffer, read one byte so the stream refills it */
+        bytes = pdfi_read_bytes(ctx, &c, 1, 1, s);
+        if (bytes < 0)
+            return_error(gs_error_ioerror);
+        if (bytes == 0)
+            return 0;
+        if (!iswhite(c)) {
+            pdfi_unread(ctx, s, &c, 1);
+            return 0;
+        }
+    }
 
     do {
         bytes = pdfi_read_bytes(ctx, &c, 1, 1, s);
@@ -146,6 +212,103 @@ int pdfi_skip_eol(pdf_context *ctx, pdf_c_stream *s)
     return 0;
 }
 
+/* Fast path for pdfi_read_num(). Handles the common, well formed, case of a number
+ * which is entirely in the stream buffer, an optional sign followed by no more
+ * than 9 digits and at most one decimal point, so that it can't overflow. We
+ * build the value as we go rather than copying the digits out and calling sscanf.
+ * Anything else (exponents, malformed or very long numbers, numbers which
+ * straddle the end of the buffer) returns 0 without consuming anything and is
+ * left to the general code below.
+ */
+static const double pdfi_pow10[10] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+/* Scan a number of the form above from the avail bytes at p. Returns the length
+ * of the number with its value in *value, or 0 if it needs the general code.
+ */
+static uint pdfi_scan_num(const byte *p, uint avail, double *value, bool *real)
+{
+    uint n = 0, digits = 0, frac_digits = 0;
+    bool negative = false;
+    int32_t v = 0;
+
+    *real = false;
+    if (avail == 0)
+        return 0;
+
+    if (p[0] == '-' || p[0] == '+') {
+        negative = (p[0] == '-');
+        n++;
+    }
+    for (; n < avail; n++) {
+        if (pdfi_char_class[p[n]] & PDFI_CHAR_DIGIT) {
+            if (++digits > 9)
+                return 0;
+            v = v * 10 + (p[n] - '0');
+            if (*real)
+                frac_digits++;
+        } else if (p[n] == '.') {
+            if (*real)
+                return 0;
+            *real = true;
+        } else
+            break;
+    }
+    /* Must have seen at least one digit, and be properly terminated within the buffer */
+    if (digits == 0 || n >= avail || isregular(p[n]))
+        return 0;
+
+    if (*real)
+        *value = (float)((double)v / pdfi_pow10[frac_digits]);
+    else
+        *value = (double)v;
+    if (negative)
+        *value = -*value;
+    return n;
+}
+
+static int pdfi_read_num_buffered(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    const byte *p;
+    uint avail, n;
+    bool real;
+    double value;
+    pdf_num *num;
+    int code;
+
+    avail = pdfi_buffered_bytes(s, &p);
+    n = pdfi_scan_num(p, avail, &value, &real);
+    if (n == 0)
+        return 0;
+
+    code = pdfi_object_alloc(ctx, real ? PDF_REAL : PDF_INT, 0, (pdf_obj **)&num);
+    if (code < 0)
+        return code;
+
+    if (real)
+        num->value.d = value;
+    else
+        num->value.i = (int64_t)value;
+
+    /* Consume the number, and a white space terminator, but leave a delimiter */
+    pdfi_skip_buffered(s, iswhite(p[n]) ? n + 1 : n);
+
+    if (ctx->args.pdfdebug) {
+        if (real)
+            dmprintf1(ctx->memory, " %f", num->value.d);
+        else
+            dmprintf1(ctx->memory, " %"PRIi64, num->value.i);
+    }
+    num->indirect_num = indirect_num;
+    num->indirect_gen = indirect_gen;
+
+    code = pdfi_push(ctx, (pdf_obj *)num);
+    if (code < 0) {
+        pdfi_free_object((pdf_obj *)num);
+        return code;
+    }
+    return 1;
+}
+
 static int pdfi_read_num(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, uint32_t indirect_gen)
 {
     byte Buffer[256];
@@ -162,6 +325,10 @@ static int pdfi_read_num(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_nu
 
     pdfi_skip_white(ctx, s);
 
+    code = pdfi_read_num_buffered(ctx, s, indirect_num, indirect_gen);
+    if (code != 0)
+        return code < 0 ? code : 0;
+
     do {
         bytes = pdfi_read_bytes(ctx, (byte *)&Buffer[index], 1, 1, s);
         if (bytes == 0 && s->eof) {
@@ -365,6 +532,34 @@ static int pdfi_read_name(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_n
     uint32_t size = 256;
     pdf_name *name = NULL;
     int code;
+    const byte *p;
+    uint avail, n;
+
+    /* If the whole name is in the stream buffer, and has no escapes, make the
+     * name object straight from the buffer.
+     */
+    avail = pdfi_buffered_bytes(s, &p);
+    if (avail > 0) {
+        for (n = 0; n < avail && isregular(p[n]) && p[n] != '#'; n++);
+        if (n < avail && p[n] != '#') {
+            code = pdfi_object_alloc(ctx, PDF_NAME, n, (pdf_obj **)&name);
+            if (code < 0)
+                return code;
+            memcpy(name->data, p, n);
+            name->indirect_num = indirect_num;
+            name->indirect_gen = indirect_gen;
+
+            if (ctx->args.pdfdebug)
+                dmprintf2(ctx->memory, " /%.*s", (int)n, (const char *)p);
+
+            pdfi_skip_buffered(s, iswhite(p[n]) ? n + 1 : n);
+
+            code = pdfi_push(ctx, (pdf_obj *)name);
+            if (code < 0)
+                pdfi_free_object((pdf_obj *)name);
+            return code;
+        }
+    }
 
     Buffer = (char *)gs_alloc_bytes(ctx->memory, size, "pdfi_read_name");
     if (Buffer == NULL)
@@ -454,6 +649,20 @@ static int pdfi_read_hexstring(pdf_context *ctx, pdf_c_stream *s, uint32_t indir
         dmprintf(ctx->memory, " <");
 
     do {
+        /* Decode runs of unbroken hex pairs straight from the stream buffer */
+        if (!ctx->args.pdfdebug) {
+            const byte *p;
+            uint avail, n = 0;
+
+            avail = pdfi_buffered_bytes(s, &p);
+            while (n + 1 < avail && index < size - 1 && ishex(p[n]) && ishex(p[n + 1])) {
+                Buffer[index++] = (fromhex(p[n]) << 4) + fromhex(p[n + 1]);
+                n += 2;
+            }
+            if (n > 0)
+                pdfi_skip_buffered(s, n);
+        }
+
         do {
             bytes = pdfi_read_bytes(ctx, (byte *)HexBuf, 1, 1, s);
             if (bytes == 0 && s->eof)
@@ -798,27 +1007,53 @@ static int pdfi_read_keyword(pdf_context *ctx, pdf_c_stream *s, uint32_t indirec
     short bytes = 0;
     int code;
     pdf_keyword *keyword;
+    const byte *p;
+    uint avail, n;
 
     pdfi_skip_white(ctx, s);
 
-    do {
-        bytes = pdfi_read_bytes(ctx, (byte *)&Buffer[index], 1, 1, s);
-        if (bytes < 0)
-            return_error(gs_error_ioerror);
+    /* Take the keyword directly from the stream buffer if it's all there. Like the
+     * loop below, this leaves the terminating byte in the stream.
+     */
+    avail = pdfi_buffered_bytes(s, &p);
+    if (avail > 0) {
+        for (n = 0; n < avail && n < 255 && isregular(p[n]); n++);
+        if (n < avail && n < 255) {
+            memcpy(Buffer, p, n);
+            index = n;
+            pdfi_skip_buffered(s, n);
+            /* Inline image data is read by filters applied directly to the underlying
+             * stream, which don't see anything we've unread. The loop below leaves the
+             * white space after 'ID' in the unread buffer, so it isn't treated as image
+             * data, do the same here.
+             */
+            if (n == 2 && Buffer[0] == 'I' && Buffer[1] == 'D' && iswhite(p[n])) {
+                pdfi_skip_buffered(s, 1);
+                pdfi_unread(ctx, s, (byte *)&p[n], 1);
+            }
+        }
+    }
 
-        if (bytes > 0) {
-            if (iswhite(Buffer[index])) {
-                pdfi_unread(ctx, s, (byte *)&Buffer[index], 1);
-                break;
-            } else {
-                if (isdelimiter(Buffer[index])) {
+    if (index == 0) {
+        do {
+            bytes = pdfi_read_bytes(ctx, (byte *)&Buffer[index], 1, 1, s);
+            if (bytes < 0)
+                return_error(gs_error_ioerror);
+
+            if (bytes > 0) {
+                if (iswhite(Buffer[index])) {
                     pdfi_unread(ctx, s, (byte *)&Buffer[index], 1);
                     break;
+                } else {
+                    if (isdelimiter(Buffer[index])) {
+                        pdfi_unread(ctx, s, (byte *)&Buffer[index], 1);
+                        break;
+                    }
                 }
+                index++;
             }
-            index++;
-        }
-    } while (bytes && index < 255);
+        } while (bytes && index < 255);
+    }
 
     if (index >= 255 || index == 0) {
         if (ctx->args.pdfstoponerror)
@@ -997,14 +1232,26 @@ int pdfi_read_token(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, ui
     int32_t bytes = 0;
     char Buffer[256];
     int code;
+    const byte *p;
+    bool buffered = false;
 
     pdfi_skip_white(ctx, s);
 
-    bytes = pdfi_read_bytes(ctx, (byte *)Buffer, 1, 1, s);
-    if (bytes < 0)
-        return (gs_error_ioerror);
-    if (bytes == 0 && s->eof)
-        return 0;
+    /* Take the first byte from the stream buffer if we can, so that when it's
+     * put back for a number or keyword it goes back in the buffer, not the
+     * unread buffer, and their fast paths can see the whole token.
+     */
+    if (pdfi_buffered_bytes(s, &p) > 0) {
+        Buffer[0] = p[0];
+        pdfi_skip_buffered(s, 1);
+        buffered = true;
+    } else {
+        bytes = pdfi_read_bytes(ctx, (byte *)Buffer, 1, 1, s);
+        if (bytes < 0)
+            return (gs_error_ioerror);
+        if (bytes == 0 && s->eof)
+            return 0;
+    }
 
     switch(Buffer[0]) {
         case 0x30:
@@ -1020,7 +1267,10 @@ int pdfi_read_token(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, ui
         case '+':
         case '-':
         case '.':
-            pdfi_unread(ctx, s, (byte *)&Buffer[0], 1);
+            if (buffered)
+                pdfi_unskip_buffered(s);
+            else
+                pdfi_unread(ctx, s, (byte *)&Buffer[0], 1);
             code = pdfi_read_num(ctx, s, indirect_num, indirect_gen);
             if (code < 0)
                 return code;
@@ -1103,7 +1353,10 @@ int pdfi_read_token(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, ui
                     return_error(gs_error_syntaxerror);
                 return pdfi_read_token(ctx, s, indirect_num, indirect_gen);
             }
-            pdfi_unread(ctx, s, (byte *)&Buffer[0], 1);
+            if (buffered)
+                pdfi_unskip_buffered(s);
+            else
+                pdfi_unread(ctx, s, (byte *)&Buffer[0], 1);
             return pdfi_read_keyword(ctx, s, indirect_num, indirect_gen);
             break;
     }
@@ -1129,76 +1382,83 @@ int pdfi_name_alloc(pdf_context *ctx, byte *n, uint32_t size, pdf_obj **o)
     return 0;
 }
 
-static char op_table_3[5][3] = {
-    "BDC", "BMC", "EMC", "SCN", "scn"
-};
-
-static char op_table_2[39][2] = {
-    "b*", "BI", "BT", "BX", "cm", "CS", "cs", "EI", "d0", "d1", "Do", "DP", "ET", "EX", "f*", "gs", "ID", "MP", "re", "RG",
-    "rg", "ri", "SC", "sc", "sh", "T*", "Tc", "Td", "TD", "Tf", "Tj", "TJ", "TL", "Tm", "Tr", "Ts", "Tw", "Tz", "W*",
-};
-
-static char op_table_1[27][1] = {
-    "b", "B", "c", "d", "f", "F", "G", "g", "h", "i", "j", "J", "K", "k", "l", "m", "n", "q", "Q", "s", "S", "v", "w", "W",
-    "y", "'", "\""
-};
+#define K1(a) (a)
+#define K2(a, b) ((a << 8) + b)
+#define K3(a, b, c) ((a << 16) + (b << 8) + c)
 
 /* forward definition for the 'split_bogus_operator' function to use */
 static int pdfi_interpret_stream_operator(pdf_context *ctx, pdf_c_stream *source,
                                           pdf_dict *stream_dict, pdf_dict *page_dict);
 
-static int search_table_3(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
+/* Check whether the first 'length' bytes of str are a content stream operator. The
+ * bytes are packed into an integer, in the same way as pdfi_interpret_stream_operator()
+ * does, and we switch on that rather than comparing against each entry of a table.
+ */
+static bool is_stream_operator(unsigned char *str, int length)
 {
-    int i, code = 0;
-
-    for (i = 0; i < 5; i++) {
-        if (memcmp(str, op_table_3[i], 3) == 0) {
-            code = pdfi_object_alloc(ctx, PDF_KEYWORD, 3, (pdf_obj **)key);
-            if (code < 0)
-                return code;
-            memcpy((*key)->data, str, 3);
-            (*key)->key = TOKEN_NOT_A_KEYWORD;
-            pdfi_countup(*key);
-            return 1;
-        }
+    uint32_t op = 0;
+    int i;
+
+    for (i = 0; i < length; i++)
+        op = (op << 8) + str[i];
+
+    switch(op) {
+        case K3('B','D','C'): case K3('B','M','C'): case K3('E','M','C'):
+        case K3('S','C','N'): case K3('s','c','n'):
+            return length == 3;
+        case K2('b','*'): case K2('B','I'): case K2('B','T'): case K2('B','X'):
+        case K2('c','m'): case K2('C','S'): case K2('c','s'): case K2('E','I'):
+        case K2('d','0'): case K2('d','1'): case K2('D','o'): case K2('D','P'):
+        case K2('E','T'): case K2('E','X'): case K2('f','*'): case K2('g','s'):
+        case K2('I','D'): case K2('M','P'): case K2('r','e'): case K2('R','G'):
+        case K2('r','g'): case K2('r','i'): case K2('S','C'): case K2('s','c'):
+        case K2('s','h'): case K2('T','*'): case K2('T','c'): case K2('T','d'):
+        case K2('T','D'): case K2('T','f'): case K2('T','j'): case K2('T','J'):
+        case K2('T','L'): case K2('T','m'): case K2('T','r'): case K2('T','s'):
+        case K2('T','w'): case K2('T','z'): case K2('W','*'):
+            return length == 2;
+        case K1('b'): case K1('B'): case K1('c'): case K1('d'): case K1('f'):
+        case K1('F'): case K1('G'): case K1('g'): case K1('h'): case K1('i'):
+        case K1('j'): case K1('J'): case K1('K'): case K1('k'): case K1('l'):
+        case K1('m'): case K1('n'): case K1('q'): case K1('Q'): case K1('s'):
+        case K1('S'): case K1('v'): case K1('w'): case K1('W'): case K1('y'):
+        case K1('\''): case K1('"'):
+            return length == 1;
+        default:
+            return false;
     }
-    return 0;
 }
 
-static int search_table_2(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
+/* If str starts with an operator 'length' bytes long, make a keyword for it */
+static int search_operator(pdf_context *ctx, unsigned char *str, int length, pdf_keyword **key)
 {
-    int i, code = 0;
+    int code = 0;
 
-    for (i = 0; i < 39; i++) {
-        if (memcmp(str, op_table_2[i], 2) == 0) {
-            code = pdfi_object_alloc(ctx, PDF_KEYWORD, 2, (pdf_obj **)key);
-            if (code < 0)
-                return code;
-            memcpy((*key)->data, str, 2);
-            (*key)->key = TOKEN_NOT_A_KEYWORD;
-            pdfi_countup(*key);
-            return 1;
-        }
-    }
-    return 0;
+    if (!is_stream_operator(str, length))
+        return 0;
+
+    code = pdfi_object_alloc(ctx, PDF_KEYWORD, length, (pdf_obj **)key);
+    if (code < 0)
+        return code;
+    memcpy((*key)->data, str, length);
+    (*key)->key = TOKEN_NOT_A_KEYWORD;
+    pdfi_countup(*key);
+    return 1;
 }
 
-static int search_table_1(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
+static int search_table_3(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
 {
-    int i, code = 0;
+    return search_operator(ctx, str, 3, key);
+}
 
-    for (i = 0; i < 39; i++) {
-        if (memcmp(str, op_table_1[i], 1) == 0) {
-            code = pdfi_object_alloc(ctx, PDF_KEYWORD, 1, (pdf_obj **)key);
-            if (code < 0)
-                return code;
-            memcpy((*key)->data, str, 1);
-            (*key)->key = TOKEN_NOT_A_KEYWORD;
-            pdfi_countup(*key);
-            return 1;
-        }
-    }
-    return 0;
+static int search_table_2(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
+{
+    return search_operator(ctx, str, 2, key);
+}
+
+static int search_table_1(pdf_context *ctx, unsigned char *str, pdf_keyword **key)
+{
+    return search_operator(ctx, str, 1, key);
 }
 
 static int split_bogus_operator(pdf_context *ctx, pdf_c_stream *source, pdf_dict *stream_dict, pdf_dict *page_dict)
@@ -1356,10 +1616,6 @@ error_exit:
     return code;
 }
 
-#define K1(a) (a)
-#define K2(a, b) ((a << 8) + b)
-#define K3(a, b, c) ((a << 16) + (b << 8) + c)
-
 static int pdfi_interpret_stream_operator(pdf_context *ctx, pdf_c_stream *source,
                                           pdf_dict *stream_dict, pdf_dict *page_dict)
 {
@@ -2011,6 +2267,241 @@ pdfi_interpret_inner_content_stream(pdf_context *ctx, pdf_stream *stream_obj,
     return pdfi_interpret_inner_content(ctx, NULL, stream_obj, page_dict, stoponerror, desc);
 }
 
+/* Decide whether to pre-parse the content of stream_obj. We only do this
+ * for Form XObjects, and only when one is run for the second time, so that
+ * forms which are used once don't hold on to their tokens.
+ */
+static bool
+pdfi_content_should_cache(pdf_context *ctx, pdf_stream *stream_obj)
+{
+    pdf_dict *stream_dict = NULL;
+    pdf_name *n = NULL;
+    bool is_form;
+
+    if (stream_obj->object_num == 0 || stream_obj->content_uses < 0 ||
+        ctx->form_cache_tokens >= MAX_FORM_CACHE_TOKENS)
+        return false;
+    if (pdfi_dict_from_obj(ctx, (pdf_obj *)stream_obj, &stream_dict) < 0 ||
+        pdfi_dict_knownget_type(ctx, stream_dict, "Subtype", PDF_NAME, (pdf_obj **)&n) <= 0)
+        return false;
+    is_form = pdfi_name_is(n, "Form");
+    pdfi_countdown(n);
+    if (!is_form)
+        return false;
+    return ++stream_obj->content_uses > 1;
+}
+
+/* Read all the tokens of a content stream into stream_obj->content_tokens,
+ * grouping each operator with its operands. Returns 1 if this worked, or 0
+ * if the content can't be replayed this way (inline images, which read
+ * their data straight from the stream, anything but a plain operator, an
+ * operator inside an array or dictionary, or too many tokens). In that
+ * case the stream has to be interpreted again from the start.
+ */
+static int
+pdfi_read_content_tokens(pdf_context *ctx, pdf_c_stream *stream, pdf_stream *stream_obj)
+{
+    int base = pdfi_count_stack(ctx), code, i, n;
+    pdf_obj **tokens = NULL, **new_tokens;
+    uint32_t count = 0, size = 0;
+    pdf_keyword *keyword;
+
+    do {
+        code = pdfi_read_token(ctx, stream, stream_obj->object_num, stream_obj->generation_num);
+        if (code < 0)
+            goto fail;
+        n = pdfi_count_stack(ctx) - base;
+        if (n > 0 && ctx->stack_top[-1]->type == PDF_KEYWORD) {
+            keyword = (pdf_keyword *)ctx->stack_top[-1];
+            if (keyword->key == TOKEN_ENDSTREAM) {
+                pdfi_pop(ctx, 1);
+                break;
+            }
+            /* BI, ID and EI are the only operators containing an 'I'. Longer
+             * keywords might be split into operators which include them.
+             */
+            if (keyword->key != TOKEN_NOT_A_KEYWORD || keyword->length > 3 ||
+                memchr(keyword->data, 'I', keyword->length) != NULL)
+                goto fail;
+            for (i = 0; i < n; i++) {
+                pdf_obj_type type = ctx->stack_top[i - n]->type;
+
+                if (type == PDF_ARRAY_MARK || type == PDF_DICT_MARK || type == PDF_PROC_MARK)
+                    goto fail;
+            }
+            if (count + n > MAX_FORM_CACHE_TOKENS - ctx->form_cache_tokens)
+                goto fail;
+            if (count + n > size) {
+                size = max(size * 2, count + n + 256);
+                new_tokens = (pdf_obj **)gs_alloc_bytes(ctx->memory, (size_t)size * sizeof(pdf_obj *),
+                                                        "pdfi_read_content_tokens");
+                if (new_tokens == NULL)
+                    goto fail;
+                if (count > 0)
+                    memcpy(new_tokens, tokens, count * sizeof(pdf_obj *));
+                gs_free_object(ctx->memory, tokens, "pdfi_read_content_tokens");
+                tokens = new_tokens;
+            }
+            for (i = 0; i < n; i++) {
+                tokens[count] = ctx->stack_top[i - n];
+                pdfi_countup(tokens[count]);
+                count++;
+            }
+            pdfi_pop(ctx, n);
+        }
+    } while (!stream->eof);
+    /* Operands left at the end would be discarded unused */
+    pdfi_pop(ctx, pdfi_count_stack(ctx) - base);
+
+    stream_obj->content_tokens = tokens;
+    stream_obj->content_token_count = count;
+    ctx->form_cache_tokens += count;
+    return 1;
+
+fail:
+    for (i = 0; i < count; i++)
+        pdfi_countdown(tokens[i]);
+    gs_free_object(ctx->memory, tokens, "pdfi_read_content_tokens");
+    if (pdfi_count_stack(ctx) > base)
+        pdfi_pop(ctx, pdfi_count_stack(ctx) - base);
+    stream_obj->content_uses = -1;
+    return code == gs_error_VMerror ? code : 0;
+}
+
+/* Run the pre-parsed content of a stream, as the loop in
+ * pdfi_interpret_content_stream would run the tokens if it read them.
+ */
+static int
+pdfi_interpret_content_tokens(pdf_context *ctx, pdf_stream *stream_obj, pdf_dict *page_dict)
+{
+    pdf_dict *stream_dict = NULL;
+    uint32_t i;
+    int code;
+
+    code = pdfi_dict_from_obj(ctx, (pdf_obj *)stream_obj, &stream_dict);
+    if (code < 0)
+        return code;
+
+    for (i = 0; i < stream_obj->content_token_count; i++) {
+        pdf_obj *o = stream_obj->content_tokens[i];
+
+        code = pdfi_push(ctx, o);
+        if (code < 0)
+            return code;
+        if (o->type != PDF_KEYWORD)
+            continue;
+        /* Recording only allows operators which can't read from the stream */
+        do {
+            code = pdfi_interpret_stream_operator(ctx, NULL, stream_dict, page_dict);
+        } while (code == REPAIRED_KEYWORD);
+        if (code < 0) {
+            pdfi_set_error(ctx, code, NULL, E_PDF_TOKENERROR, "pdfi_interpret_content_tokens", NULL);
+            if (ctx->args.pdfstoponerror) {
+                pdfi_clearstack(ctx);
+                return code;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Content streams from engineering drawings and maps are frequently little more
+ * than very long runs of path construction operators, and tokenising those makes
+ * a number object for every coordinate, pushes it, and pops it again. When the
+ * operands and operators are all in the stream buffer, and the numbers are simple
+ * enough for pdfi_scan_num(), we decode a run of them into an array of coordinates
+ * instead, and then append the segments to the path. Anything else (including an
+ * operator with the wrong number of operands) ends the run, and is left to the
+ * general code. Returns the number of segments appended, or an error if we should
+ * stop on errors.
+ */
+#define PATH_RUN_MAX_SEGMENTS 128
+
+static int pdfi_interpret_path_run(pdf_context *ctx, pdf_c_stream *s)
+{
+    byte ops[PATH_RUN_MAX_SEGMENTS];
+    double values[PATH_RUN_MAX_SEGMENTS * 6], *v;
+    const byte *p;
+    uint avail, n = 0, used = 0, len;
+    int count = 0, nvalues = 0, operands = 0, needed, i, code;
+    bool real;
+
+    avail = pdfi_buffered_bytes(s, &p);
+    while (count < PATH_RUN_MAX_SEGMENTS) {
+        while (n < avail && iswhite(p[n]))
+            n++;
+        if (n >= avail)
+            break;
+
+        if (pdfi_char_class[p[n]] & PDFI_CHAR_DIGIT || p[n] == '-' || p[n] == '+' || p[n] == '.') {
+            if (operands == 6)
+                break;
+            len = pdfi_scan_num(p + n, avail - n, &values[nvalues + operands], &real);
+            if (len == 0)
+                break;
+            operands++;
+            n += len;
+            continue;
+        }
+
+        len = 1;
+        switch (p[n]) {
+            case 'm': case 'l':
+                needed = 2;
+                break;
+            case 'c':
+                needed = 6;
+                break;
+            case 'v': case 'y':
+                needed = 4;
+                break;
+            case 'h':
+                needed = 0;
+                break;
+            case 'r':
+                needed = 4;
+                len = 2;
+                if (n + 1 < avail && p[n + 1] == 'e')
+                    break;
+                /* Fall through */
+            default:
+                needed = -1;
+                break;
+        }
+        if (needed != operands || n + len >= avail || isregular(p[n + len]))
+            break;
+        ops[count++] = p[n];
+        nvalues += operands;
+        operands = 0;
+        n += len;
+        used = n;
+    }
+    if (count == 0)
+        return 0;
+    pdfi_skip_buffered(s, used);
+
+    for (i = 0, v = values; i < count; i++) {
+        code = pdfi_append_path_segment(ctx, ops[i], v);
+        if (code < 0) {
+            pdfi_set_error(ctx, code, NULL, E_PDF_TOKENERROR, "pdf_interpret_content_stream", NULL);
+            if (ctx->args.pdfstoponerror)
+                return code;
+        }
+        switch (ops[i]) {
+            case 'm': case 'l':
+                v += 2;
+                break;
+            case 'c':
+                v += 6;
+                break;
+            case 'v': case 'y': case 'r':
+                v += 4;
+                break;
+        }
+    }
+    return count;
+}
+
 /*
  * Interpret a content stream.
  * content_stream -- content to parse.  If NULL, get it from the stream_dict
@@ -2021,13 +2512,15 @@ pdfi_interpret_content_stream(pdf_context *ctx, pdf_c_stream *content_stream,
                               pdf_stream *stream_obj, pdf_dict *page_dict)
 {
     int code;
-    pdf_c_stream *stream;
+    pdf_c_stream *stream = NULL;
     pdf_keyword *keyword;
     pdf_stream *s = ctx->current_stream;
+    bool read_tokens = false;
 
     if (content_stream != NULL) {
         stream = content_stream;
-    } else {
+    } else if (stream_obj->content_tokens == NULL) {
+        read_tokens = pdfi_content_should_cache(ctx, stream_obj);
         code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, stream_obj), SEEK_SET);
         if (code < 0)
             return code;
@@ -2057,7 +2550,34 @@ pdfi_interpret_content_stream(pdf_context *ctx, pdf_c_stream *content_stream,
     pdfi_set_stream_parent(ctx, stream_obj, ctx->current_stream);
     ctx->current_stream = stream_obj;
 
+    if (read_tokens) {
+        code = pdfi_read_content_tokens(ctx, stream, stream_obj);
+        if (code < 0)
+            goto exit;
+        if (code == 0) {
+            /* Start again, and interpret the stream as we read it */
+            pdfi_close_file(ctx, stream);
+            stream = NULL;
+            code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, stream_obj), SEEK_SET);
+            if (code < 0)
+                goto exit;
+            code = pdfi_filter(ctx, stream_obj, ctx->main_stream, &stream, false);
+            if (code < 0)
+                goto exit;
+        }
+    }
+    if (stream_obj->content_tokens != NULL && content_stream == NULL) {
+        code = pdfi_interpret_content_tokens(ctx, stream_obj, page_dict);
+        goto exit;
+    }
+
     do {
+        if (pdfi_count_stack(ctx) == 0 && ctx->text.BlockDepth == 0 && !ctx->args.pdfdebug) {
+            code = pdfi_interpret_path_run(ctx, stream);
+            if (code < 0)
+                goto exit;
+        }
+
         code = pdfi_read_token(ctx, stream, stream_obj->object_num, stream_obj->generation_num);
         if (code < 0) {
             if (code == gs_error_ioerror || code == gs_error_VMerror || ctx->args.pdfstoponerror) {
@@ -2130,6 +2650,7 @@ repaired_keyword:
 exit:
     ctx->current_stream = pdfi_stream_parent(ctx, stream_obj);
     pdfi_clear_stream_parent(ctx, stream_obj);
-    pdfi_close_file(ctx, stream);
+    if (stream != NULL)
+        pdfi_close_file(ctx, stream);
     return code;
 }
@@ -78,9 +78,15 @@ int pdfi_object_alloc(pdf_context *ctx, pdf_obj_type type, unsigned int size, pd
         default:
             return_error(gs_error_typecheck);
     }
-    *obj = (pdf_obj *)gs_alloc_bytes(ctx->memory, bytes, "pdfi_object_alloc");
-    if (*obj == NULL)
-        return_error(gs_error_VMerror);
+    if ((type == PDF_INT || type == PDF_REAL) && ctx->num_pool != NULL) {
+        *obj = ctx->num_pool;
+        ctx->num_pool = (pdf_obj *)(*obj)->ctx;
+        ctx->num_pool_count--;
+    } else {
+        *obj = (pdf_obj *)gs_alloc_bytes(ctx->memory, bytes, "pdfi_object_alloc");
+        if (*obj == NULL)
+            return_error(gs_error_VMerror);
+    }
 
     memset(*obj, 0x00, bytes);
     (*obj)->ctx = ctx;
@@ -200,6 +206,31 @@ int pdfi_num_alloc(pdf_context *ctx, double d, pdf_num **num)
 /* When an object's reference count is decremented to 0, pdfi_countdown calls      */
 /* pdfi_free_object() to free it.                                                  */
 
+static void pdfi_free_num(pdf_obj *o)
+{
+    pdf_context *ctx = (pdf_context *)o->ctx;
+
+    if (ctx->num_pool_count < PDFI_NUM_POOL_SIZE) {
+        o->ctx = ctx->num_pool;
+        ctx->num_pool = o;
+        ctx->num_pool_count++;
+    } else
+        gs_free_object(OBJ_MEMORY(o), o, "pdf interpreter object refcount to 0");
+}
+
+/* Release the recycled number objects, at the end of the job */
+void pdfi_free_num_pool(pdf_context *ctx)
+{
+    pdf_obj *o;
+
+    while (ctx->num_pool != NULL) {
+        o = ctx->num_pool;
+        ctx->num_pool = (pdf_obj *)o->ctx;
+        gs_free_object(ctx->memory, o, "pdfi_free_num_pool");
+    }
+    ctx->num_pool_count = 0;
+}
+
 static void pdfi_free_namestring(pdf_obj *o)
 {
     /* Currently names and strings are the same, so a single cast is OK */
@@ -232,6 +263,14 @@ static void pdfi_free_stream(pdf_obj *o)
 {
     pdf_stream *stream = (pdf_stream *)o;
 
+    if (stream->content_tokens != NULL) {
+        uint32_t i;
+
+        for (i = 0; i < stream->content_token_count; i++)
+            pdfi_countdown(stream->content_tokens[i]);
+        gs_free_object(OBJ_MEMORY(o), stream->content_tokens, "pdfi_free_stream");
+        OBJ_CTX(o)->form_cache_tokens -= stream->content_token_count;
+    }
     pdfi_countdown(stream->stream_dict);
     gs_free_object(OBJ_MEMORY(o), o, "pdfi_free_stream");
 }
@@ -243,12 +282,14 @@ void pdfi_free_object(pdf_obj *o)
         case PDF_DICT_MARK:
         case PDF_PROC_MARK:
         case PDF_NULL:
-        case PDF_INT:
-        case PDF_REAL:
         case PDF_INDIRECT:
         case PDF_BOOL:
             gs_free_object(OBJ_MEMORY(o), o, "pdf interpreter object refcount to 0");
             break;
+        case PDF_INT:
+        case PDF_REAL:
+            pdfi_free_num(o);
+            break;
         case PDF_STRING:
         case PDF_NAME:
             pdfi_free_namestring(o);
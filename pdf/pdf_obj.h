@@ -16,8 +16,18 @@
 #ifndef PDF_OBJECTS
 #define PDF_OBJECTS
 
+/* How many freed number objects we keep for reuse (see num_pool in
+ * pdf_context). Memento needs every object to go back to the allocator.
+ */
+#ifdef MEMENTO
+#define PDFI_NUM_POOL_SIZE 0
+#else
+#define PDFI_NUM_POOL_SIZE 256
+#endif
+
 int pdfi_object_alloc(pdf_context *ctx, pdf_obj_type type, unsigned int size, pdf_obj **obj);
 void pdfi_free_object(pdf_obj *o);
+void pdfi_free_num_pool(pdf_context *ctx);
 int pdfi_obj_to_string(pdf_context *ctx, pdf_obj *obj, byte **data, int *len);
 int pdfi_obj_dict_to_stream(pdf_context *ctx, pdf_dict *dict, pdf_stream **stream, bool do_convert);
 int pdfi_obj_charstr_to_string(pdf_context *ctx, const char *charstr, pdf_string **string);
@@ -445,6 +445,26 @@ int pdfi_eoclip(pdf_context *ctx)
      return code;
 }
 
+static int pdfi_append_rect(pdf_context *ctx, const double *Values)
+{
+    int code;
+
+    code = gs_moveto(ctx->pgs, Values[0], Values[1]);
+    if (code == 0) {
+        code = gs_rlineto(ctx->pgs, Values[2], 0);
+        if (code == 0){
+            code = gs_rlineto(ctx->pgs, 0, Values[3]);
+            if (code == 0) {
+                code = gs_rlineto(ctx->pgs, -Values[2], 0);
+                if (code == 0){
+                    code = gs_closepath(ctx->pgs);
+                }
+            }
+        }
+    }
+    return code;
+}
+
 int pdfi_rectpath(pdf_context *ctx)
 {
     int i, code;
@@ -473,19 +493,38 @@ int pdfi_rectpath(pdf_context *ctx)
     if (ctx->text.BlockDepth != 0)
         pdfi_set_warning(ctx, 0, NULL, W_PDF_OPINVALIDINTEXT, "pdfi_rectpath", NULL);
 
-    code = gs_moveto(ctx->pgs, Values[0], Values[1]);
-    if (code == 0) {
-        code = gs_rlineto(ctx->pgs, Values[2], 0);
-        if (code == 0){
-            code = gs_rlineto(ctx->pgs, 0, Values[3]);
-            if (code == 0) {
-                code = gs_rlineto(ctx->pgs, -Values[2], 0);
-                if (code == 0){
-                    code = gs_closepath(ctx->pgs);
-                }
-            }
-        }
-    }
+    code = pdfi_append_rect(ctx, Values);
     pdfi_pop(ctx, 4);
     return code;
 }
+
+/* Append a segment whose operands have already been decoded (see
+ * pdfi_interpret_path_run()). op is the first character of the operator.
+ */
+int pdfi_append_path_segment(pdf_context *ctx, byte op, const double *Values)
+{
+    gs_point pt;
+    int code;
+
+    switch (op) {
+        case 'm':
+            return gs_moveto(ctx->pgs, Values[0], Values[1]);
+        case 'l':
+            return gs_lineto(ctx->pgs, Values[0], Values[1]);
+        case 'c':
+            return gs_curveto(ctx->pgs, Values[0], Values[1], Values[2], Values[3], Values[4], Values[5]);
+        case 'v':
+            code = gs_currentpoint(ctx->pgs, &pt);
+            if (code < 0)
+                return code;
+            return gs_curveto(ctx->pgs, pt.x, pt.y, Values[0], Values[1], Values[2], Values[3]);
+        case 'y':
+            return gs_curveto(ctx->pgs, Values[0], Values[1], Values[2], Values[3], Values[2], Values[3]);
+        case 'h':
+            return gs_closepath(ctx->pgs);
+        case 'r':
+            return pdfi_append_rect(ctx, Values);
+        default:
+            return_error(gs_error_undefined);
+    }
+}
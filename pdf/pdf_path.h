@@ -36,5 +36,6 @@ int pdfi_B_star(pdf_context *ctx);
 int pdfi_clip(pdf_context *ctx);
 int pdfi_eoclip(pdf_context *ctx);
 int pdfi_rectpath(pdf_context *ctx);
+int pdfi_append_path_segment(pdf_context *ctx, byte op, const double *Values);
 
 #endif
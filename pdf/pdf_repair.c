@@ -24,6 +24,7 @@
 #include "pdf_file.h"
 #include "pdf_misc.h"
 #include "pdf_repair.h"
+#include "pdf_check.h"
 
 static int pdfi_repair_add_object(pdf_context *ctx, uint64_t obj, uint64_t gen, gs_offset_t offset)
 {
@@ -81,6 +82,57 @@ static int pdfi_repair_add_object(pdf_context *ctx, uint64_t obj, uint64_t gen,
     return 0;
 }
 
+/* Search forward through the main stream for the string 'test', if found return 1
+ * and the offset of the start of the string in *found, if we reach the end of the file
+ * return 0. The position of the stream is undefined afterwards, callers must seek.
+ *
+ * Stream data can make up almost all of a file, and this is used to skip over it, so
+ * rather than reading a byte at a time we read large blocks and use memchr to find
+ * the places where the string might start.
+ */
+#define REPAIR_SEARCH_BUFFER_SIZE 65536
+
+static int pdfi_repair_search(pdf_context *ctx, const char *test, int len, gs_offset_t *found)
+{
+    byte *Buffer, *p, *end;
+    gs_offset_t pos;
+    uint32_t keep = 0;
+    int bytes, code = 0;
+
+    Buffer = gs_alloc_bytes(ctx->memory, REPAIR_SEARCH_BUFFER_SIZE, "pdfi_repair_search");
+    if (Buffer == NULL)
+        return_error(gs_error_VMerror);
+
+    do {
+        /* pos is the file offset of Buffer[0] */
+        pos = pdfi_unread_tell(ctx) - keep;
+        bytes = pdfi_read_bytes(ctx, Buffer + keep, 1, REPAIR_SEARCH_BUFFER_SIZE - keep, ctx->main_stream);
+        if (bytes < 0) {
+            code = bytes;
+            break;
+        }
+        end = Buffer + keep + bytes;
+
+        for (p = Buffer; (p = memchr(p, test[0], end - p)) != NULL; p++) {
+            if (end - p < len)
+                break;
+            if (memcmp(p, test, len) == 0) {
+                *found = pos + (p - Buffer);
+                code = 1;
+                goto exit;
+            }
+        }
+
+        /* Keep any partial match at the end of the buffer, it might be completed by the next block */
+        keep = min(len - 1, end - Buffer);
+        memmove(Buffer, end - keep, keep);
+    } while (bytes > 0 && ctx->main_stream->eof == false);
+
+exit:
+    gs_free_object(ctx->memory, Buffer, "pdfi_repair_search");
+    return code;
+}
+
 int pdfi_repair_file(pdf_context *ctx)
 {
     int code = 0;
@@ -99,6 +151,9 @@ int pdfi_repair_file(pdf_context *ctx)
     ctx->repaired = true;
     pdfi_set_error(ctx, 0, NULL, E_PDF_REPAIRED, "pdfi_repair_file", NULL);
 
+    /* Object numbers may refer to different objects after repair */
+    pdfi_check_free_memo(ctx);
+
     pdfi_clearstack(ctx);
 
     if(ctx->args.pdfdebug)
@@ -108,27 +163,16 @@ int pdfi_repair_file(pdf_context *ctx)
      * and may not even be a PDF file.
      */
     pdfi_seek(ctx, ctx->main_stream, 0, SEEK_SET);
-    {
-        char Buffer[10], test[] = "%PDF";
-        int index = 0;
-
-        do {
-            code = pdfi_read_bytes(ctx, (byte *)&Buffer[index], 1, 1, ctx->main_stream);
-            if (code < 0)
-                goto exit;
-
-            if (Buffer[index] == test[index])
-                index++;
-            else
-                index = 0;
-        } while (index < 4 && ctx->main_stream->eof == false);
-        if (memcmp(Buffer, test, 4) != 0) {
-            code = gs_note_error(gs_error_undefined);
-            goto exit;
-        }
-        pdfi_unread(ctx, ctx->main_stream, (byte *)Buffer, 4);
-        pdfi_skip_comment(ctx, ctx->main_stream);
+    code = pdfi_repair_search(ctx, "%PDF", 4, &offset);
+    if (code < 0)
+        goto exit;
+    if (code == 0) {
+        code = gs_note_error(gs_error_undefined);
+        goto exit;
     }
+    pdfi_seek(ctx, ctx->main_stream, offset, SEEK_SET);
+    ctx->main_stream->eof = false;
+    pdfi_skip_comment(ctx, ctx->main_stream);
     if (ctx->main_stream->eof == true) {
         code = gs_note_error(gs_error_ioerror);
         goto exit;
@@ -228,21 +272,15 @@ int pdfi_repair_file(pdf_context *ctx)
                                     break;
                                 } else {
                                     if (k->key == TOKEN_STREAM) {
-                                        char Buffer[10], test[] = "endstream";
-                                        int index = 0;
-
-                                        do {
-                                            code = pdfi_read_bytes(ctx, (byte *)&Buffer[index], 1, 1, ctx->main_stream);
-                                            if (code < 0) {
-                                                if (code != gs_error_VMerror && code != gs_error_ioerror)
-                                                    continue;
-                                                goto exit;
-                                            }
-                                            if (Buffer[index] == test[index])
-                                                index++;
-                                            else
-                                                index = 0;
-                                        } while (index < 9 && ctx->main_stream->eof == false);
+                                        gs_offset_t endstream;
+
+                                        code = pdfi_repair_search(ctx, "endstream", 9, &endstream);
+                                        if (code < 0)
+                                            goto exit;
+                                        if (code > 0) {
+                                            pdfi_seek(ctx, ctx->main_stream, endstream + 9, SEEK_SET);
+                                            ctx->main_stream->eof = false;
+                                        }
                                         do {
                                             code = pdfi_read_token(ctx, ctx->main_stream, 0, 0);
                                             if (code < 0) {
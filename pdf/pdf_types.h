@@ -189,6 +189,14 @@ typedef struct pdf_stream_s {
     bool length_valid; /* True if Length and is_stream have been cached above */
     bool stream_written; /* Has stream been written (for pdfwrite) */
     bool is_marking;
+    /* For a Form XObject which is drawn more than once, the operands and
+     * operators of its content, read once and replayed after that (see
+     * pdfi_interpret_content_stream). content_uses counts the times the
+     * content has been run, and is -1 if it can't be pre-parsed.
+     */
+    int content_uses;
+    uint32_t content_token_count;
+    pdf_obj **content_tokens;
 } pdf_stream;
 
 typedef struct pdf_indirect_ref_s {
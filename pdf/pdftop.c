@@ -617,6 +617,11 @@ pdf_impl_set_param(pl_interp_implementation_t *impl,
             if (code < 0)
                 return code;
         }
+        if (!strncmp(param, "ReduceJPEG", 10)) {
+            code = plist_value_get_bool(&pvalue, &ctx->args.reducejpeg);
+            if (code < 0)
+                return code;
+        }
         if (!strncmp(param, "ShowAcroForm", 12)) {
             code = plist_value_get_bool(&pvalue, &ctx->args.showacroform);
             if (code < 0)
@@ -703,6 +708,13 @@ pdf_impl_set_param(pl_interp_implementation_t *impl,
             if (code < 0)
                 return code;
         }
+        if (!strncmp(param, "PDFFontIndex", strlen("PDFFontIndex"))) {
+            gs_free_object(ctx->memory, ctx->args.fontindex, "PDFFontIndex param string");
+            ctx->args.fontindex = NULL;
+            code = plist_value_get_string_or_name(ctx, &pvalue, &ctx->args.fontindex, &len);
+            if (code < 0)
+                return code;
+        }
         if (!strncmp(param, "FONTPATH", 11)) {
             char *s = NULL;
             int slen;
@@ -63,6 +63,7 @@ ialloc_init(gs_dual_memory_t *dmem, gs_memory_t * rmem, uint clump_size,
     dmem->space_system = ismem;
     dmem->spaces.vm_reclaim = gs_gc_reclaim; /* real GC */
     dmem->reclaim = 0;		/* no interpreter GC yet */
+    dmem->gc_stats.count = dmem->gc_stats.time = dmem->gc_stats.max_time = 0;
     /* Level 1 systems have only local VM. */
     igmem->space = avm_global;
     igmem_stable->space = avm_global;
@@ -31,6 +31,12 @@ typedef struct dict_stack_s dict_stack_t;
  */
 void dstack_set_top(dict_stack_t *);
 
+/*
+ * Reset the cached top values after pushing or popping a single
+ * dictionary (passed as the second argument), as begin and end do.
+ */
+void dstack_set_top_changed(dict_stack_t *, const ref *);
+
 /* Check whether a dictionary is one of the permanent ones on the d-stack. */
 bool dstack_dict_is_permanent(const dict_stack_t *, const ref *);
 
@@ -516,6 +516,7 @@ dict_put(ref * pdref /* t_dictionary */ , const ref * pkey, const ref * pvalue,
         if (r_has_type(pkey, t_name)) {
             name *pname = pkey->value.pname;
 
+            name_lookup_cache_forget(pmem, name_index(pmem, pkey));
             if (pname->pvalue == pv_no_defn &&
                 CAN_SET_PVALUE_CACHE(pds, pdref, mem)
                 ) {		/* Set the cache. */
@@ -604,6 +605,9 @@ dict_undef(ref * pdref, const ref * pkey, dict_stack_t *pds)
         if_debug3m('d', (const gs_memory_t *)mem,
                    "[d]"PRI_INTPTR": removing key at "PRI_INTPTR": 0x%x\n",
                    (intptr_t)pdict, (intptr_t)pkp, (uint)*pkp);
+        /* The key may have been given as a string. */
+        if (r_packed_is_name(pkp))
+            name_lookup_cache_forget(mem, packed_name_index(pkp));
         /* See the initial comment for why it is safe not to save */
         /* the change if the keys array itself is new. */
         if (must_save)
@@ -639,6 +643,8 @@ dict_undef(ref * pdref, const ref * pkey, dict_stack_t *pds)
         if_debug4m('d', (const gs_memory_t *)mem,
                    "[d]"PRI_INTPTR": removing key at "PRI_INTPTR": 0x%lx 0x%lx\n",
                    (intptr_t)pdict, (intptr_t)kp, ((ulong *)kp)[0], ((ulong *)kp)[1]);
+        if (r_has_type(kp, t_name))
+            name_lookup_cache_forget(mem, name_index(mem, kp));
         make_null_old_in(mem, &pdict->keys, kp, "dict_undef(key)");
         /*
          * Accumulating deleted entries slows down lookup.
@@ -819,6 +825,8 @@ dict_resize(ref * pdref, uint new_size, dict_stack_t *pds)
     ref_save_in(dict_memory(pdict), pdref, &pdict->maxlength,
                 "dict_resize(maxlength)");
     d_set_maxlength(pdict, new_size);
+    /* The values have moved. */
+    name_lookup_cache_clear(mem);
     if (pds)
         dstack_set_top(pds);	/* just in case this is the top dict */
     return 0;
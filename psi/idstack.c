@@ -77,6 +77,10 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
 #define dstack_find_name_by_index real_dstack_find_name_by_index
 #endif
 
+/* Get the name table, for the lookup cache. */
+#define dstack_name_table(pds)\
+  (((gs_memory_t *)(pds)->stack.memory)->gs_lib_ctx->gs_name_table)
+
 /* Check whether a dictionary is one of the permanent ones on the d-stack. */
 bool
 dstack_dict_is_permanent(const dict_stack_t * pds, const ref * pdref)
@@ -101,17 +105,24 @@ dstack_dict_is_permanent(const dict_stack_t * pds, const ref * pdref)
 /*
  * Look up a name on the dictionary stack.
  * Return the pointer to the value if found, 0 if not.
+ * Successful searches are remembered in the name table's lookup cache
+ * (see inamedef.h).
  */
 ref *
 dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
 {
     ds_ptr pdref = pds->stack.p;
+    name_table *nt = dstack_name_table(pds);
+    name_lookup_entry *pent = names_lookup_entry_inline(nt, nidx);
+    ref *pvalue;
 
 /* Since we know the hash function is the identity function, */
 /* there's no point in allocating a separate variable for it. */
 #define hash dict_name_index_hash(nidx)
     ref_packed kpack = packed_name_key(nidx);
 
+    if (pent->nidx == nidx && pent->gen == nt->lookup_gen)
+        return pent->pvalue;
     do {
         dict *pdict = pdref->value.pdict;
         uint size = npairs(pdict);
@@ -131,7 +142,7 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
 #define INCR_DEPTH(pdref)\
   INCR(depth[min(MAX_STATS_DEPTH, pds->stack.p - pdref)])
         if (dict_is_packed(pdict)) {
-#	    define found INCR_DEPTH(pdref); return packed_search_value_pointer
+#	    define found INCR_DEPTH(pdref); pvalue = packed_search_value_pointer; goto found
 #	    define deleted
 #	    define missing break;
 #	    include "idicttpl.h"
@@ -155,7 +166,8 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
                 if (r_has_type(kp, t_name)) {
                     if (name_index(_mem_not_used, kp) == nidx) {
                         INCR_DEPTH(pdref);
-                        return pdict->values.value.refs + (kp - kbot);
+                        pvalue = pdict->values.value.refs + (kp - kbot);
+                        goto found;
                     }
                 } else if (r_has_type(kp, t_null)) {	/* Empty, deleted, or wraparound. */
                     /* Figure out which. */
@@ -181,7 +193,6 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
         ref key;
         uint i = pds->stack.p + 1 - pds->stack.bot;
         uint size = ref_stack_count(&pds->stack);
-        ref *pvalue;
 
         dict *pdict = pds->stack.p->value.pdict;
         const gs_memory_t *mem = dict_mem(pdict);
@@ -192,11 +203,16 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
                           &key, &pvalue) > 0
                 ) {
                 INCR(depth[min(MAX_STATS_DEPTH, i)]);
-                return pvalue;
+                goto found;
             }
         }
     }
     return (ref *) 0;
+found:
+    pent->nidx = nidx;
+    pent->gen = nt->lookup_gen;
+    pent->pvalue = pvalue;
+    return pvalue;
 #undef hash
 }
 
@@ -204,8 +220,8 @@ dstack_find_name_by_index(dict_stack_t * pds, uint nidx)
 /* See idstack.h for details. */
 static const ref_packed no_packed_keys[2] =
 {packed_key_deleted, packed_key_empty};
-void
-dstack_set_top(dict_stack_t * pds)
+static void
+dstack_load_top(dict_stack_t * pds)
 {
     ds_ptr dsp = pds->stack.p;
     dict *pdict = dsp->value.pdict;
@@ -227,6 +243,48 @@ dstack_set_top(dict_stack_t * pds)
     else
         pds->def_space = r_space(dsp);
 }
+void
+dstack_set_top(dict_stack_t * pds)
+{
+    dstack_load_top(pds);
+    names_lookup_cache_clear(dstack_name_table(pds));
+}
+
+/*
+ * Set the cached values after a single dictionary has been pushed onto
+ * or popped from the dstack.  Only the lookups of names defined in that
+ * dictionary can be affected, so if it is small, we invalidate just
+ * those names in the lookup cache rather than the whole cache.
+ */
+#define MAX_FORGET_SLOTS 64
+void
+dstack_set_top_changed(dict_stack_t * pds, const ref * pdref)
+{
+    const dict *pdict = pdref->value.pdict;
+    name_table *nt = dstack_name_table(pds);
+    uint size = nslots(pdict);
+    uint i;
+
+    dstack_load_top(pds);
+    if (size > MAX_FORGET_SLOTS) {
+        names_lookup_cache_clear(nt);
+        return;
+    }
+    if (dict_is_packed(pdict)) {
+        const ref_packed *kp = pdict->keys.value.packed;
+
+        for (i = 0; i < size; ++i, ++kp)
+            if (r_packed_is_name(kp))
+                names_lookup_cache_forget(nt, packed_name_index(kp));
+    } else {
+        const ref *kp = pdict->keys.value.refs;
+
+        for (i = 0; i < size; ++i, ++kp)
+            if (r_has_type(kp, t_name))
+                names_lookup_cache_forget(nt, names_index(nt, kp));
+    }
+}
+#undef MAX_FORGET_SLOTS
 
 /* After a garbage collection, scan the permanent dictionaries and */
 /* update the cached value pointers in names. */
@@ -236,6 +294,8 @@ dstack_gc_cleanup(dict_stack_t * pds)
     uint count = ref_stack_count(&pds->stack);
     uint dsi;
 
+    /* Dictionary values may have moved. */
+    names_lookup_cache_clear(dstack_name_table(pds));
     for (dsi = pds->min_size; dsi > 0; --dsi) {
         const dict *pdict =
         ref_stack_index(&pds->stack, count - dsi)->value.pdict;
@@ -1223,6 +1223,7 @@ gs_finit_push_systemdict(i_ctx_t *i_ctx_p)
     }
     dsp++;
     ref_assign(dsp, systemdict);
+    dict_set_top();
 }
 
 /* Free all resources and return. */
@@ -84,6 +84,12 @@ struct gs_dual_memory_s {
     /* Masks for store checking, see isave.h. */
     uint test_mask;
     uint new_mask;
+    /* Garbage collection statistics, maintained by ireclaim.c. */
+    struct {
+        long count;		/* number of collections */
+        long time;		/* total elapsed time in ms */
+        long max_time;		/* longest single collection in ms */
+    } gc_stats;
 };
 
 #define public_st_gs_dual_memory()	/* in ialloc.c */\
@@ -96,6 +96,7 @@ names_init(ulong count, gs_ref_memory_t *imem)
         ((count - 1) | nt_sub_index_mask) >> nt_log2_sub_size;
     nt->name_string_attrs = imemory_space(imem) | a_readonly;
     nt->memory = mem;
+    nt->lookup_gen = 1;
     /* Initialize the one-character names. */
     /* Start by creating the necessary sub-tables. */
     for (i = 0; i < NT_1CHAR_FIRST + NT_1CHAR_SIZE; i += nt_sub_size) {
@@ -283,6 +284,28 @@ names_invalidate_value_cache(name_table * nt, const ref * pnref)
     pnref->value.pname->pvalue = pv_other;
 }
 
+/* Invalidate the dictionary stack lookup cache. */
+void
+names_lookup_cache_clear(name_table * nt)
+{
+    if (nt == NULL)
+        return;
+    if (++(nt->lookup_gen) == 0) {
+        /* Don't let old entries become valid again after wraparound. */
+        memset(nt->lookup, 0, sizeof(nt->lookup));
+        nt->lookup_gen = 1;
+    }
+}
+
+/* Invalidate the dictionary stack lookup cache entry for one name. */
+void
+names_lookup_cache_forget(name_table * nt, name_index_t nidx)
+{
+    if (nt == NULL)
+        return;
+    names_lookup_entry_inline(nt, nidx)->gen = 0;
+}
+
 /* Convert between names and indices. */
 #undef names_index
 name_index_t
@@ -61,6 +61,12 @@
 #define name_invalidate_value_cache(mem, pnref)\
   names_invalidate_value_cache(mem->gs_lib_ctx->gs_name_table, pnref)
 
+/* Invalidate the dictionary stack lookup cache. */
+#define name_lookup_cache_clear(mem)\
+  names_lookup_cache_clear(mem->gs_lib_ctx->gs_name_table)
+#define name_lookup_cache_forget(mem, nidx)\
+  names_lookup_cache_forget(mem->gs_lib_ctx->gs_name_table, nidx)
+
 /* Convert between names and indices. */
 #define name_index(mem, pnref)		/* ref => index */\
   names_index(mem->gs_lib_ctx->gs_name_table, pnref)
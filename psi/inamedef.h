@@ -89,6 +89,25 @@ typedef struct name_sub_table_s {
 #endif
 } name_sub_table;
 
+/*
+ * Define the dictionary stack lookup cache.  Names that are defined in
+ * more than one place can't use the pvalue cache, and would otherwise
+ * require a search of every dictionary on the stack on each reference;
+ * this includes most of the commonly used operators.  The cache is
+ * direct-mapped by name index and holds the value pointer found by the
+ * last search.  An entry is only valid if its gen matches lookup_gen,
+ * which is advanced whenever the dictionary stack changes or values may
+ * have moved (dictionary resizing, restore, garbage collection); since
+ * that includes every collection, the value pointers are not traced.
+ * Defining or undefining a name only invalidates that name's entry.
+ */
+#define NT_LOOKUP_SIZE 512	/* must be a power of 2 */
+typedef struct name_lookup_entry_s {
+    uint nidx;
+    uint gen;			/* 0 = unused */
+    ref *pvalue;
+} name_lookup_entry;
+
 /*
  * Now define the name table itself.
  * This must be made visible so that the interpreter can use the
@@ -105,6 +124,8 @@ struct name_table_s {
     uint name_string_attrs;	/* imemory_space(memory) | a_readonly */
     gs_memory_t *memory;
     uint hash[NT_HASH_SIZE];
+    uint lookup_gen;		/* never 0 */
+    name_lookup_entry lookup[NT_LOOKUP_SIZE];
     struct sub_ {		/* both ptrs are 0 or both are non-0 */
         name_sub_table *names;
         name_string_sub_table_t *strings;
@@ -134,6 +155,9 @@ struct name_table_s {
 #  define names_index_inline(nt_ignored, pnref) r_size(pnref)
 #endif
 #define names_index(nt_ignored, pnref) names_index_inline(nt_ignored, pnref)
+                /* index => lookup cache entry */
+#define names_lookup_entry_inline(nt, nidx)\
+  (&(nt)->lookup[(nidx) & (NT_LOOKUP_SIZE - 1)])
                 /* index => name */
 #define names_index_ptr_inline(nt, nidx)\
   ((nt)->sub[(nidx) >> nt_log2_sub_size].names->names +\
@@ -84,6 +84,13 @@ int names_from_string(name_table * nt, const ref * psref, ref * pnref);
 /* Invalidate the value cache for a name. */
 void names_invalidate_value_cache(name_table * nt, const ref * pnref);
 
+/*
+ * Invalidate the dictionary stack lookup cache, either entirely or only
+ * for a single name.  See inamedef.h.
+ */
+void names_lookup_cache_clear(name_table * nt);
+void names_lookup_cache_forget(name_table * nt, name_index_t nidx);
+
 /* Convert between names and indices. */
 name_index_t names_index(const name_table * nt, const ref * pnref);		/* ref => index */
 name *names_index_ptr(const name_table * nt, name_index_t nidx);	/* index => name */
@@ -17,6 +17,7 @@
 /* Interpreter's interface to garbage collector */
 #include "ghost.h"
 #include "ierrors.h"
+#include "gp.h"			/* for gp_get_realtime */
 #include "gsstruct.h"
 #include "iastate.h"
 #include "icontext.h"
@@ -113,9 +114,11 @@ gs_vmreclaim(gs_dual_memory_t *dmem, bool global)
     gs_ref_memory_t *memories[5];
     gs_ref_memory_t *mem;
     int nmem, i;
+    long start[2], end[2], elapsed;
 
     if (code < 0)
         return code;
+    gp_get_realtime(start);
 
     memories[0] = dmem->space_system;
     memories[1] = mem = dmem->space_global;
@@ -188,6 +191,15 @@ gs_vmreclaim(gs_dual_memory_t *dmem, bool global)
        we would lose those allocations when the clumps were opened */
 
     code = context_state_load(i_ctx_p);
+
+    /* Update the statistics. */
+
+    gp_get_realtime(end);
+    elapsed = (end[0] - start[0]) * 1000 + (end[1] - start[1]) / 1000000;
+    dmem->gc_stats.count++;
+    dmem->gc_stats.time += elapsed;
+    if (elapsed > dmem->gc_stats.max_time)
+        dmem->gc_stats.max_time = elapsed;
     return code;
 }
 
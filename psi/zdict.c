@@ -72,7 +72,7 @@ zbegin(i_ctx_t *i_ctx_p)
     }
     ++dsp;
     ref_assign(dsp, op);
-    dict_set_top();
+    dstack_set_top_changed(&idict_stack, op);
     pop(1);
     return 0;
 }
@@ -81,16 +81,19 @@ zbegin(i_ctx_t *i_ctx_p)
 int
 zend(i_ctx_t *i_ctx_p)
 {
+    ref popped;
+
     if (ref_stack_count_inline(&d_stack) == min_dstack_size) {
         /* We would underflow the d-stack. */
         return_error(gs_error_dictstackunderflow);
     }
+    ref_assign(&popped, dsp);
     while (dsp == dsbot) {
         /* We would underflow the current block. */
         ref_stack_pop_block(&d_stack);
     }
     dsp--;
-    dict_set_top();
+    dstack_set_top_changed(&idict_stack, &popped);
     return 0;
 }
 
@@ -1048,6 +1048,19 @@ static int zPDFInit(i_ctx_t *i_ctx_p)
             pdfctx->ctx->encryption.PasswordLen = r_size(pvalueref);
         }
 
+        if (dict_find_string(pdictref, "PDFFontIndex", &pvalueref) > 0) {
+            if (!r_has_type(pvalueref, t_string))
+                goto error;
+            gs_free_object(pdfctx->ctx->memory, pdfctx->ctx->args.fontindex, "PDF font index from zpdfops");
+            pdfctx->ctx->args.fontindex = (char *)gs_alloc_bytes(pdfctx->ctx->memory, r_size(pvalueref) + 1, "PDF font index from zpdfops");
+            if (pdfctx->ctx->args.fontindex == NULL) {
+                code = gs_note_error(gs_error_VMerror);
+                goto error;
+            }
+            memcpy(pdfctx->ctx->args.fontindex, pvalueref->value.const_bytes, r_size(pvalueref));
+            pdfctx->ctx->args.fontindex[r_size(pvalueref)] = 0x00;
+        }
+
         if (dict_find_string(pdictref, "FirstPage", &pvalueref) > 0) {
             if (!r_has_type(pvalueref, t_integer))
                 goto error;
@@ -1126,6 +1139,12 @@ static int zPDFInit(i_ctx_t *i_ctx_p)
             pdfctx->ctx->args.showannots = pvalueref->value.boolval;
         }
 
+        if (dict_find_string(pdictref, "ReduceJPEG", &pvalueref) > 0) {
+            if (!r_has_type(pvalueref, t_boolean))
+                goto error;
+            pdfctx->ctx->args.reducejpeg = pvalueref->value.boolval;
+        }
+
         if (dict_find_string(pdictref, "PreserveAnnots", &pvalueref) > 0) {
             if (!r_has_type(pvalueref, t_boolean))
                 goto error;
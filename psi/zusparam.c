@@ -230,6 +230,21 @@ current_PageCount(i_ctx_t *i_ctx_p)
         	i_ctx_p->nv_page_count = dev->ShowpageCount;
     return 1000 + i_ctx_p->nv_page_count; /* Add 1000 to imitate NV memory */
 }
+static long
+current_GCCount(i_ctx_t *i_ctx_p)
+{
+    return idmemory->gc_stats.count;
+}
+static long
+current_GCTime(i_ctx_t *i_ctx_p)
+{
+    return idmemory->gc_stats.time;
+}
+static long
+current_GCMaxTime(i_ctx_t *i_ctx_p)
+{
+    return idmemory->gc_stats.max_time;
+}
 
 static const size_t_param_def_t system_size_t_params[] =
 {
@@ -243,7 +258,11 @@ static const long_param_def_t system_long_params[] =
     {"MaxFontCache", 0, MAX_UINT_PARAM, current_MaxFontCache, set_MaxFontCache},
     {"CurFontCache", 0, MAX_UINT_PARAM, current_CurFontCache, NULL},
     {"Revision", min_long, max_long, current_Revision, NULL},
-    {"PageCount", min_long, max_long, current_PageCount, NULL}
+    {"PageCount", min_long, max_long, current_PageCount, NULL},
+    /* Extensions */
+    {"GCCount", 0, max_long, current_GCCount, NULL},
+    {"GCTime", 0, max_long, current_GCTime, NULL},
+    {"GCMaxTime", 0, max_long, current_GCMaxTime, NULL}
 };
 
 /* Boolean values */
@@ -469,6 +488,14 @@ current_VMThreshold(i_ctx_t *i_ctx_p)
     return stat.vm_threshold;
 }
 static long
+current_VMThresholdRatio(i_ctx_t *i_ctx_p)
+{
+    gs_memory_gc_status_t stat;
+
+    gs_memory_gc_status(iimemory_local, &stat);
+    return stat.threshold_ratio;
+}
+static long
 current_WaitTimeout(i_ctx_t *i_ctx_p)
 {
     return 0;
@@ -644,7 +671,9 @@ static const long_param_def_t user_long_params[] =
     {"AlignToPixels", 0, 1,
      current_AlignToPixels, set_AlignToPixels},
     {"GridFitTT", 0, 3,
-     current_GridFitTT, set_GridFitTT}
+     current_GridFitTT, set_GridFitTT},
+    {"VMThresholdRatio", 0, 10000,
+     current_VMThresholdRatio, set_vm_threshold_ratio}
 };
 
 /* Note that string objects that are maintained as user params must be
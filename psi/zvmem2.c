@@ -90,6 +90,19 @@ set_vm_threshold(i_ctx_t *i_ctx_p, int64_t val)
     return 0;
 }
 
+/*
+ * Set the minimum GC interval as a percentage of the VM in use after
+ * the previous collection (a Ghostscript extension); 0 disables this.
+ */
+int
+set_vm_threshold_ratio(i_ctx_t *i_ctx_p, long val)
+{
+    gs_memory_set_vm_threshold_ratio(idmemory->space_system, (int)val);
+    gs_memory_set_vm_threshold_ratio(idmemory->space_global, (int)val);
+    gs_memory_set_vm_threshold_ratio(idmemory->space_local, (int)val);
+    return 0;
+}
+
 int
 set_vm_reclaim(i_ctx_t *i_ctx_p, long val)
 {